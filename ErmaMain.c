@@ -126,6 +126,33 @@ static ERMAPARAMS ep =
      //rather the median times ns_medianMult. If avgPower is above this product,
      //it's evidence that a glider motor is on.
      "saved_percentiles",
+
+     //encStateFileName: where findEncounters leaves off at the end of a run,
+     //so an encounter that goes on across runs (e.g., across the end of one
+     //dive and the start of the next) is found as one encounter. It's in
+     //baseDir, and a profile's name is appended to it (see ermaProfile.c).
+     "encounter_state",
+
+     //clickLogFileName: a binary file in the <outDir> directory that every
+     //click found is appended to, run after run, for looking up clicks by time
+     //(see clickLog.h, and "ErmaMain -clicklog"). As with encStateFileName, a
+     //profile's name is appended to it. The empty string means don't keep it,
+     //which is the default: it takes four fsyncs for each file processed,
+     //which is slow on the Pi's SD card. "click_log" is the usual name.
+     "",
+
+     //journalFileName: a file in baseDir that the bookkeeping (files_processed
+     //marks, all_dets lines, and noise percentiles) goes into during a run,
+     //in place of many small writes to those files; at the end of the run it's
+     //carried out on them and emptied. See journal.h. The empty string means
+     //write those files directly.
+     "erma_journal",
+
+     //dirScanFileName: a file in baseDir where the search for new input files
+     //remembers which directories had nothing new in them, so they needn't be
+     //read again until they change (see dirScan.c). Delete it if you take
+     //names out of filesProcessed. The empty string means read them all.
+     "dir_scan_state",
      /************************** end of file names ***************************/
 
      /* GPIO pins */
@@ -148,6 +175,8 @@ static ERMAPARAMS ep =
      3,		 //decim: decimation factor for downsampling
      NULL,NULL,0,//numerA/B/N: IIR filter for numerator in ERMA calc
      NULL,NULL,0,//denomA/B/N: IIR filter for denominator in ERMA calc
+     {0, 0},	 //numerBand: passband of numerA/B, Hz; {0,0} means default
+     {0, 0},	 //denomBand: passband of denomA/B, Hz; {0,0} means default
 
      /* stuff for ERMA algorithm: */
      0.25,	//decayTime: exponential-decay constant for expdecay()
@@ -165,6 +194,14 @@ static ERMAPARAMS ep =
      1e7,	//ignoreThresh: sams this loud don't affect running mean
      0.1,	//ignoreLimT: ...unless they last for this long
      0.010,	//specLenS: time window for calculating averaged click spectra
+     1.0,	//contMaxGapS: max gap between files for carrying DSP state over
+		//    (WISPR file times are whole seconds)
+     0.010,	//warmupS: don't detect in this much of a segment after a reset
+     0,		//gateThresh: energy gate: pass windows this * median; 0 = no gate
+     0.005,	//gateWinS: energy gate window length, s
+     4,		//gateDecim: energy gate uses every gateDecim'th sample
+     6000,	//gateFreq: energy gate is most sensitive at this frequency, Hz
+     0.25,	//gateMarginS: run ERMA this long before a window the gate passes
      
      /* stuff for testClickDets: */
      40,	//minRate: min required click period over whole file, s
@@ -179,6 +216,8 @@ static ERMAPARAMS ep =
      3,		//hitsPerEnc: min number of block hits in the consecutive
 		//    blocks needed to register as an encounter */
      1000, 	//clicksToSave: number of clicks to save per dive
+     0,		//encBinary: 1 = upload a binary encounter report instead of the
+		//    CSV; "ErmaMain -decodeenc" turns it back into the CSV
      
      /* stuff for glider noise removal: */
 //    0.1,	*///ns_tBlockS: block duration for measuring noise, s
@@ -187,11 +226,29 @@ static ERMAPARAMS ep =
      0.10,	//ns_pctile: percentile for measuring background noise level
      12,	//ns_nRecent: number of recent ns_pctile values to get median of
      4.0,	//ns_medianMult: thresh = this * median(recent ns_pctile values)
+     10,	//ns_saveEvery: save recent ns_pctile values every this many files
      //		//ns_thresh obsolete; now gotten from pctile,nRecent,medianMult
 /*     2e4,     *///ns_thresh: noise threshold [Perimeter .wav files]
 /*     4e8,	*///ns_thresh: noise threshold [glider .dat files]
      0.1,	//ns_padSec: pad noise periods w/this for ramp up/down
      0.1,	//ns_minQuietS: minimum length of a noise section
+     0,		//ns_decimate: 1 = find quiet times from every decim'th
+		//    sample only, which is quicker (its recent ns_pctile
+		//    values are kept in pctFileName plus "-decim")
+     0,		//ns_onlineChunkS: >0 = read file in chunks this long, s,
+		//    finding quiet times and running ERMA on them as it goes;
+		//    10 is about right
+
+     /* stuff for bookkeeping: */
+     10,	//journalSyncFiles: fsync the journal every this many files...
+     60,	//journalSyncS: ...or this many seconds, whichever comes first
+
+     /* stuff for all_dets output: */
+     0,		//allDetsBinary: 1 = also write the clicks to a binary
+		//    all_dets file (.bin) in fixed-width columns; see
+		//    allDetsBin.h. 2 = write only that, not the CSV. The
+		//    ermaExport program turns it back into the CSV.
+     0,		//allDetsSpectra: 1 = put click spectra in binary all_dets too
     };
 
 
@@ -201,26 +258,40 @@ static ERMAPARAMS ep =
 
 
 /* Declarations for stuff defined down below */
-char **readFilesProcessed(char *filename);
-char **getNewFiles(char **filesProcessedList, char *dir, char *inputSoundDir);
+void readFilesProcessed(char *filename, STRSET *processed);
 void appendToProcessed(char *filepart, char *filesProcessed);
+static int sweepMain(char *tool, int nFiles, char **files);
 
-/* This holds all the clicks that have been found this run. */
-static ALLCLICKS allC;		/* all clicks found in all files */
-static ENCOUNTERS enc;
+/* These are the detector profiles. Each holds all the clicks it has found this
+ * run and its encounters. Normally there's just one; see ermaProfile.c.
+ */
+static ERMAPROFILE *prof;
+static int32 nProf;
 
 int main(int argc, char **argv)
 {
-    char **filesProcessedList;		//list of files done on prev runs
+    STRSET filesProcessedSet;		//files done on prev runs
     char **unprocessedFiles;		//list of files to do on this run
-    char allDetsPath[256];		//stores all click dets
-    char piEncDetsPath[256];		//name here of encounter clicks file
-    char wisprEncDetsPath[256];		//name on WISPR of encounter clicks file
     char buf[256];			//temp buffer for making allDetsPath
     char encFileListPath[256];		//stores list of encounter output files
     char filesProcessedPath[256];	//full path for filesProcessed
     unsigned int pinval;
 
+    /* "ErmaMain -sweep [soundfile ...]" runs a parameter sweep instead of the
+     * usual processing, and "ErmaMain -gatereport [soundfile ...]" a report on
+     * the energy gate; see ermaSweep.c. */
+    if (argc > 1 && (!strcmp(argv[1], "-sweep") ||
+		     !strcmp(argv[1], "-gatereport")))
+	return sweepMain(argv[1], argc - 2, argv + 2);
+    /* "ErmaMain -clicklog logFile [from to [binS]]" counts clicks in the click
+     * log; see clickLog.c. */
+    if (argc > 1 && !strcmp(argv[1], "-clicklog"))
+	return clickLogMain(argc - 2, argv + 2);
+    /* "ErmaMain -decodeenc report [out.csv]" turns a binary encounter report
+     * back into the CSV; see encReport.c. */
+    if (argc > 1 && !strcmp(argv[1], "-decodeenc"))
+	return encRepMain(argc - 2, argv + 2);
+
     printf("In ErmaMain.c/main()\n");
     
     printf("Looking for files in %s/%s\n", baseDir, ep.infilePattern);
@@ -245,21 +316,30 @@ int main(int argc, char **argv)
 
     /* Initialization */
     time_t startTime = time(NULL);
-    initENCOUNTERS(&enc);
-    initALLCLICKS(&allC);
     ERMACONFIG *ec = ermaReadConfigFile(baseDir, configFileName);
     gatherErmaParams(ec, &ep);
+    nProf = ermaGetProfiles(ec, &ep, &prof);
 
     /* printERMACONFIG(ec);*/
     
+    /* Open the journal, first finishing off any bookkeeping left in it by a
+     * run that didn't get to the end (see journal.h). */
+    if (ep.journalFileName[0] != '\0') {
+	snprintf(buf, sizeof(buf), "%s/%s", baseDir, ep.journalFileName);
+	journalOpen(buf, ep.journalSyncFiles, ep.journalSyncS);
+    }
+
     /* Get a list of files that have already been processed */
     snprintf(filesProcessedPath, sizeof(filesProcessedPath), "%s/%s",
 	     baseDir, ep.filesProcessed);
-    filesProcessedList = readFilesProcessed(filesProcessedPath);
+    readFilesProcessed(filesProcessedPath, &filesProcessedSet);
 
-    /* Make a list of unprocessed sound files. It's NULL if there's an error. */
-    unprocessedFiles =
-	getNewFiles(filesProcessedList, baseDir, ep.infilePattern);
+    /* Make a list of unprocessed sound files. It's NULL if there's an error.
+     * See dirScan.c. */
+    snprintf(buf, sizeof(buf), "%s%s%s", baseDir,
+	     ep.dirScanFileName[0] ? "/" : "", ep.dirScanFileName);
+    unprocessedFiles = getNewFiles(&filesProcessedSet, baseDir,
+				   ep.infilePattern, buf);
 
     /* Process the unprocessed files. BEFORE processing each file, the filename
      * is saved to filesProcessed (files_processed.txt); that way, if some file
@@ -269,19 +349,15 @@ int main(int argc, char **argv)
 	/* Construct the name of the output files. The output file for this run
 	 * (allDetsPath) is named with the part of the first input soundfile
 	 * after the "WISPR_" prefix - this is normally the date/time stamp -
-	 * and with a .csv extension.
+	 * and with a .csv extension. Each profile has its own output files.
 	 * Note: a path name is also constructed in quietTimes.c.
 	 */
 	pathRoot(buf, pathFile(unprocessedFiles[0]));
 	char *fileTimestamp = !strncmp(buf,"WISPR_",6) ? buf+6 : buf;
-	snprintf(allDetsPath, sizeof(allDetsPath), "%s/%s/%s-%s.csv",
-		 baseDir, ep.outDir, ep.allDetsPrefix, fileTimestamp);
-	//piEncDetsPath is in baseDir, not baseDir/outDir.
-	snprintf(piEncDetsPath, sizeof(piEncDetsPath), "%s/%s-%s.csv",
-		 baseDir, ep.encDetsPrefix, fileTimestamp);
-	char *sep = (strlen(ep.wisprEncFileDir) > 0) ? "/" : "";
-	snprintf(wisprEncDetsPath, sizeof(wisprEncDetsPath), "%s%s%s-%s.csv",
-		 ep.wisprEncFileDir, sep, ep.encDetsPrefix, fileTimestamp);
+	for (int32 p = 0; p < nProf; p++) {
+	    ermaProfileSetPaths(&prof[p], baseDir, fileTimestamp);
+	    encStateRead(&prof[p].encState, &prof[p].ep, prof[p].encStatePath);
+	}
 	snprintf(encFileListPath, sizeof(encFileListPath), "%s/%s",
 		 baseDir, ep.encFileList);
 
@@ -296,7 +372,7 @@ int main(int argc, char **argv)
 	    appendToProcessed(pathFile(unprocessedFiles[i]),filesProcessedPath);
 /*	    printf("******* DEBUG: not appending to files_processed.txt**\n");*/
 
-	    processFile(unprocessedFiles[i], allDetsPath, &ep, &allC,
+	    processFile(unprocessedFiles[i], &ep, prof, nProf,
 			&tMinE, &tMaxE, baseDir);
 
 	    /* Check to be sure that WISPR wants RPi to keep running */
@@ -308,14 +384,28 @@ int main(int argc, char **argv)
 	    }
 	    #endif
 	}
+	quietTimesSavePcts();
+	journalSync();			//all_dets etc. are safe in the journal
 	printf("main(): Done processing files. Saving encounters.\n");
-
-	/* Find and save encounters. First check if WISPR needs a shutdown. */
+	printStageTimes();
+
+	/* Save encounters. processFile has kept them up to date, so this is
+	 * quick enough to do even if WISPR needs a shutdown. It's done before
+	 * the journal is compacted, which takes an fsync per file. */
+	for (int32 p = 0; p < nProf; p++) {
+	    ERMAPROFILE *pr = &prof[p];
+	    findEncounters(&pr->allC, &pr->ep, &pr->encState, &pr->enc);
+	    finishEncounters(&pr->encState, &pr->ep, &pr->enc);
+	    encStateWrite(&pr->encState, pr->encStatePath);
+	    saveEncounters(&pr->enc, &pr->allC, pr->piEncDetsPath,
+			   pr->wisprEncDetsPath, tMinE, tMaxE,
+			   encFileListPath, pr->ep.clicksToSave, startTime,
+			   pr->ep.encBinary);
+	}
+	/* Finish off all_dets etc. On a fast quit, leave that to the next
+	 * boot's journalOpen. */
 	if (!fastQuit) {
-	    findEncounters(&allC, &ep, &enc);
-	    saveEncounters(&enc, &allC, piEncDetsPath, wisprEncDetsPath,
-			   tMinE, tMaxE, encFileListPath, ep.clicksToSave,
-			   startTime);
+	    journalClose();
 	    printf("Exiting normally.\n");
 	}
     }
@@ -334,114 +424,65 @@ int main(int argc, char **argv)
 }
 
 
-/* Read the file that has a list of the files that have been processed (or
- * attempted to be processed).
+/* Run a parameter sweep or gate report (see ermaSweep.c), as picked by tool,
+ * on the nFiles soundfiles in files, or if there are none, on all the files
+ * matching infilePattern, processed or not. This doesn't wait for WISPR or
+ * touch the GPIO pins.
  */
-char **readFilesProcessed(char *filename)
+static int sweepMain(char *tool, int nFiles, char **files)
 {
-    char **filelist, **p;
-    size_t filelistSize;
-    int32 nFiles;
-    size_t lnSize;
-    char *ln;
-    FILE *fp;
-
-    fp = fopen(filename, "r");	/* check for fp==NULL is below */
-    filelist = NULL;
-    filelistSize = 0;
-    nFiles = 0;
-    while (1) {
-	BUFGROW(filelist, nFiles + 1, ERMA_NO_MEMORY_FILELIST);
-	filelist[nFiles] = NULL;
-	if (fp == NULL)		/* can only happen first time thru loop */
-	    return filelist;	/* need filelist to be defined upon return */
-	ln = NULL;
-	lnSize = 0;
-	if (getline(&ln, &lnSize, fp) < 0) {	/* reached end of file? */
-	    fclose(fp);
-	    return filelist;
-	}
-	
-	if (lnSize > 0) {
-	    /* Strip trailing \r or \n from ln, then stash it away */
-	    if (ln[strlen(ln)-1] == '\r' || ln[strlen(ln)-1] == '\n')
-		ln[strlen(ln)-1] = '\0';
-	    filelist[nFiles++] = ln;
-	}
+    ERMACONFIG *ec = ermaReadConfigFile(baseDir, configFileName);
+    gatherErmaParams(ec, &ep);
+    ep.ns_onlineChunkS = 0;		//the sweep tools read whole files
+    nProf = ermaGetProfiles(ec, &ep, &prof);
+
+    char **sweepFiles;
+    if (nFiles > 0)
+	sweepFiles = files;		//argv is NULL-terminated
+    else {
+	sweepFiles = getNewFiles(NULL, baseDir, ep.infilePattern, "");
+	if (sweepFiles == NULL)
+	    return 0;
     }
+    int ret;
+    if (!strcmp(tool, "-gatereport"))
+	ret = ermaGateReport(sweepFiles, ec, &ep, prof, nProf, baseDir);
+    else
+	ret = ermaSweep(sweepFiles, ec, &ep, prof, nProf, baseDir);
+    quietTimesSavePcts();
+    return ret;
 }
 
 
-/* Get a list of unprocessed files - those that match the pattern (template) in
- * infilePattern and aren't yet in the file list filesProcessedList. Returns a
- * new NULL-terminated array of pathnames with malloc'ed strings having the
- * names that aren't yet processed, or NULL if there's something wrong with the
- * infilePattern.
+/* Read the file that has a list of the files that have been processed (or
+ * attempted to be processed) into the set 'processed'. The file is read in one
+ * go, and the names in the set point into that copy of it, which is kept. A
+ * missing file means nothing has been processed yet.
+ *
+ * This is done on every boot and the list gets long over a mission, so it's
+ * kept quick: a hash set makes looking up each file in getNewFiles take about
+ * the same time however long the list is, where a scan of the whole list took
+ * time in proportion to its length. See the benchmark in ermaGoodies.c.
  */
-char **getNewFiles(char **filesProcessedList, char *dir, char *infilePattern)
+void readFilesProcessed(char *filename, STRSET *processed)
 {
-    glob_t globbufDir, globbuf;
-    char templt0[256], templt1[256], templtDir[256];
-
-    /* Make a complete template with both dir template/name and file template */
-    snprintf(templt0, sizeof(templt0), "%s/%s", dir, infilePattern);
-    
-    /* Get a list of files that match templt0, by globbing first the directory,
-     * then the files in each directory. These are separate steps because
-     * globbing both the directory name and the file name together might produce
-     * a huge list of files that's too large for glob. First glob the
-     * directory. */
-    pathDir(templtDir, templt0);
-    if (glob(templtDir, GLOB_NOESCAPE, NULL, &globbufDir) != 0)
-	return NULL;
-
-    /* Walk through list of directories that matched the directory template. */
-    char *tfn = pathFile(templt0);	//template file name
-    char **unprocessed = NULL;
-    size_t unprocessedSize = 0;		//for bufgrow
-    int32 nFiles = 0;
-    for (int di = 0; di < globbufDir.gl_pathc; di++) {
-	/* For each dir, append the filename pattern and glob the result to get
-	 * an array of filenames. Append each one to 'unprocessed' if it's not
-	 * already in filesProcessedList. */
-	snprintf(templt1, sizeof(templt1), "%s/%s",
-		 globbufDir.gl_pathv[di], tfn);
-	if (glob(templt1, GLOB_NOESCAPE, NULL, &globbuf) != 0)
-	    return NULL;
-	
-	/* Walk through globbed array of files. For each one, see if it's in the
-	 * list of processed files; if not, add it to the unprocessed list. */
-	for (int32 i = 0; i < globbuf.gl_pathc; i++) {
-	    //Get next WISPR filename, but at the point after the last \ or /.
-	    char *fn = globbuf.gl_pathv[i];
-	    if (findInList(pathFile(fn), filesProcessedList) < 0) {
-		BUFGROW(unprocessed, nFiles + 1, ERMA_NO_MEMORY_UNPROCESSED);
-		unprocessed[nFiles++] = strsave(fn);
-	    }
-	}
-	globfree(&globbuf);
-    }
-    globfree(&globbufDir);
-    BUFGROW(unprocessed, nFiles + 1, ERMA_NO_MEMORY_UNPROCESSED);
-    unprocessed[nFiles] = NULL;
-
-    printf("getNewFiles: %d new files to process\n", nFiles);
-    return unprocessed;
+    initSTRSET(processed);
+    char *buf = readWholeFile(filename, NULL);
+    if (buf != NULL)
+	strSetAddLines(processed, buf);
 }
 
 
 /* Append a filepart (the part of a filename without the directory name(s)) to
- * the list of processed files in filesProcessedPath. The latter file is opened
- * and closed every time this is called to reduce the chance that it gets
- * mangled if the system crashes or powered down.
+ * the list of processed files in filesProcessedPath. This goes by way of the
+ * journal, which is written (along with the previous file's records) before
+ * this returns, so it isn't lost if processing the file crashes or hangs.
  */
 void appendToProcessed(char *filepart, char *filesProcessedPath)
 {
-    FILE *fp;
+    char ln[strlen(filepart) + 2];
 
-    fp = fopen(filesProcessedPath, "a");
-    if (fp != NULL) {
-	fprintf(fp, "%s\n", filepart);
-	fclose(fp);
-    }
+    snprintf(ln, sizeof(ln), "%s\n", filepart);
+    journalAppend(filesProcessedPath, ln, strlen(ln));
+    journalMark();		//out of our hands before the file is processed
 }
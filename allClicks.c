@@ -0,0 +1,207 @@
+#include "erma.h"
+
+/* The store of all clicks found this run. See allClicks.h for how it's laid
+ * out.
+ */
+
+#define SEC_PER_DAY	(24*60*60)
+
+
+void initALLCLICKS(ALLCLICKS *ac)
+{
+    ac->chunk = NULL;
+    ac->chunkSize = 0;
+    ac->base = NULL;
+    ac->baseSize = 0;
+    ac->nBase = 0;
+    ac->n = 0;
+    ac->lastD = 0;
+    ac->sorted = 1;
+}
+
+
+/* Free the memory in ac and make it empty.
+ */
+void freeALLCLICKS(ALLCLICKS *ac)
+{
+    for (int32 k = 0; k * CLICK_CHUNK < ac->n; k++)
+	free(ac->chunk[k]);
+    free(ac->chunk);
+    free(ac->base);
+    initALLCLICKS(ac);
+}
+
+
+/* Add a click timeS seconds into a file that starts at timeE (seconds since
+ * the Epoch) to the end of ac. If the last base in ac isn't timeE, a new base
+ * is started.
+ */
+void allClicksAdd(ALLCLICKS *ac, double timeE, float timeS)
+{
+    if (ac->nBase == 0 || ac->base[ac->nBase-1].timeE != timeE) {
+	BUFGROW(ac->base, ac->nBase + 1, ERMA_NO_MEMORY_APPENDCLICKS);
+	ac->base[ac->nBase].timeE = timeE;
+	ac->base[ac->nBase].first = ac->n;
+	ac->nBase++;
+    }
+
+    int32 k = ac->n / CLICK_CHUNK, j = ac->n % CLICK_CHUNK;
+    if (j == 0) {
+	BUFGROW(ac->chunk, k + 1, ERMA_NO_MEMORY_APPENDCLICKS);
+	ac->chunk[k] = malloc(CLICK_CHUNK * sizeof(ac->chunk[k][0]));
+	if (ac->chunk[k] == NULL)
+	    exit(ERMA_NO_MEMORY_APPENDCLICKS);
+    }
+    ac->chunk[k][j] = timeS;
+
+    double tD = ((double)timeS + timeE) / SEC_PER_DAY;
+    if (ac->n > 0 && tD < ac->lastD)
+	ac->sorted = 0;
+    ac->lastD = tD;
+    ac->n++;
+}
+
+
+/* Append the clicks in the FILECLICKS fc, which has seconds in a file that
+ * starts at fileTimeE (seconds since the Epoch), to the ALLCLICKS ac.
+ */
+void appendClicks(ALLCLICKS *ac, FILECLICKS *fc, double fileTimeE)
+{
+    for (int32 i = 0; i < fc->n; i++)
+	allClicksAdd(ac, fileTimeE, fc->timeS[i]);
+}
+
+
+/* Return the index in ac->base of the base of click i. */
+static int32 baseOf(ALLCLICKS *ac, int32 i)
+{
+    int32 lo = 0, hi = ac->nBase - 1;	//base[lo].first <= i always
+    while (lo < hi) {
+	int32 mid = lo + (hi - lo + 1) / 2;
+	if (ac->base[mid].first <= i)
+	    lo = mid;
+	else
+	    hi = mid - 1;
+    }
+    return lo;
+}
+
+
+/* Set up it to go through the clicks in ac starting with click i. */
+void clickIterStart(CLICKITER *it, ALLCLICKS *ac, int32 i)
+{
+    it->ac = ac;
+    it->i = i;
+    it->b = (i < ac->n) ? baseOf(ac, i) : 0;
+}
+
+
+/* Put the time of the next click from it, in days since the Epoch, in *pTimeD
+ * and return 1, or return 0 if there are no more.
+ */
+int clickIterNext(CLICKITER *it, double *pTimeD)
+{
+    ALLCLICKS *ac = it->ac;
+    int32 i = it->i;
+
+    if (i >= ac->n)
+	return 0;
+    while (it->b + 1 < ac->nBase && ac->base[it->b + 1].first <= i)
+	it->b++;
+    *pTimeD = ((double)ac->chunk[i / CLICK_CHUNK][i % CLICK_CHUNK] +
+	       ac->base[it->b].timeE) / SEC_PER_DAY;
+    it->i++;
+    return 1;
+}
+
+
+/* Return the time of click i in ac in days since the Epoch. */
+double allClicksTimeD(ALLCLICKS *ac, int32 i)
+{
+    return ((double)ac->chunk[i / CLICK_CHUNK][i % CLICK_CHUNK] +
+	    ac->base[baseOf(ac, i)].timeE) / SEC_PER_DAY;
+}
+
+
+/* One click, taken out of an ALLCLICKS for sorting. */
+typedef struct {
+    double tD;		//days since the Epoch, the sort key
+    double timeE;
+    float timeS;
+} SORTCLICK;
+
+
+static int cmpSortClick(const void *a, const void *b)
+{
+    double x = ((const SORTCLICK *)a)->tD, y = ((const SORTCLICK *)b)->tD;
+    return (x > y) - (x < y);
+}
+
+
+/* Put the clicks in ac in time order, if they aren't already. This only costs
+ * anything if files were processed out of order, in which case the clicks are
+ * taken out, sorted, and put back, with new bases.
+ */
+void sortALLCLICKS(ALLCLICKS *ac)
+{
+    if (ac->sorted)
+	return;
+
+    int32 n = ac->n;
+    SORTCLICK *sc = malloc(MAX(1, n) * sizeof(sc[0]));
+    if (sc == NULL)
+	exit(ERMA_NO_MEMORY_APPENDCLICKS);
+    for (int32 b = 0; b < ac->nBase; b++) {
+	int32 end = (b + 1 < ac->nBase) ? ac->base[b + 1].first : n;
+	for (int32 i = ac->base[b].first; i < end; i++) {
+	    sc[i].timeE = ac->base[b].timeE;
+	    sc[i].timeS = ac->chunk[i / CLICK_CHUNK][i % CLICK_CHUNK];
+	    sc[i].tD = ((double)sc[i].timeS + sc[i].timeE) / SEC_PER_DAY;
+	}
+    }
+    qsort(sc, n, sizeof(sc[0]), cmpSortClick);
+
+    freeALLCLICKS(ac);
+    for (int32 i = 0; i < n; i++)
+	allClicksAdd(ac, sc[i].timeE, sc[i].timeS);
+    free(sc);
+}
+
+
+/* Return the index of the first click in ac whose time is after tD, in days
+ * since the Epoch (or, if orEqual is 1, at or after it), or ac->n if there's
+ * none. This is a binary search, so ac must be sorted (see sortALLCLICKS).
+ */
+int32 allClicksFirstAfter(ALLCLICKS *ac, double tD, int orEqual)
+{
+    int32 lo = 0, hi = ac->n;
+    while (lo < hi) {
+	int32 mid = lo + (hi - lo) / 2;
+	double t = allClicksTimeD(ac, mid);
+	if (t < tD || (!orEqual && t == tD))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+
+/* For debugging.
+ */
+void writeALLCLICKS(ALLCLICKS *ac, char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    CLICKITER it;
+    double tD;
+
+    clickIterStart(&it, ac, 0);
+    while (clickIterNext(&it, &tD)) {
+	double timeE_dbl = tD * SEC_PER_DAY;
+	time_t timeE_int = (time_t)floor(timeE_dbl);
+	char *asc = asctime(gmtime(&timeE_int));
+	float fracSec = remainder(timeE_dbl, 1.0L);
+	fprintf(fp, "%s%4.3f\n", asc, fracSec);
+    }
+    fclose(fp);
+}
@@ -0,0 +1,63 @@
+#ifndef _ALLCLICKS_H_
+#define _ALLCLICKS_H_
+
+/* ALLCLICKS holds the whale clicks found in all files this run. There can be a
+ * great many of them on a long run, so rather than a double for each one, it
+ * keeps the start time of each file as a double and, for each click, its float
+ * time in the file, just as it was found (FILECLICKS.timeS). That's half the
+ * memory, and a click's time in days since the Epoch, worked out as
+ * ((double)timeS + timeE) / secPerDay, is the same double that used to be
+ * stored, so the times written to the CSV files don't change in the last
+ * digit. The times are kept in chunks of CLICK_CHUNK that stay where they are
+ * once allocated, so adding clicks never copies the ones already there.
+ *
+ * Go through the clicks with a CLICKITER, or use allClicksTimeD to get one.
+ * Files are normally processed in time order, so the clicks are normally in
+ * time order too; appendClicks keeps track of whether they are, and
+ * sortALLCLICKS makes sure of it for things that search by time.
+ *
+ * (The typedef for ALLCLICKS is in ermaNew.h, which needs it first.)
+ */
+#define CLICK_CHUNK		4096		//number of clicks per chunk
+
+/* Click times that are stored as integers, as in the click log (clickLog.h),
+ * are in ticks of 1/CLICK_TICKS_PER_S s. */
+#define CLICK_TICKS_PER_S	1000000		//1-us ticks
+
+typedef struct {
+    double timeE;	//start time of the file, s since the Epoch (1/1/1970)
+    int32 first;	//index of its first click
+} CLICKBASE;
+
+struct allclicks {
+    float **chunk;	//chunk[k][j] is the time in its file of click
+			//k*CLICK_CHUNK+j, s
+    size_t chunkSize;	//for bufgrow
+    CLICKBASE *base;	//file start times, in order of first click
+    size_t baseSize;	//for bufgrow
+    int32 nBase;	//number of elements in base
+    int32 n;		//number of clicks
+    double lastD;	//time of the last click added, days since the Epoch
+    int sorted;		//1 if the clicks are in non-decreasing time order
+};
+
+/* A CLICKITER goes through the clicks in an ALLCLICKS in order; it saves
+ * looking up each click's file start time. */
+typedef struct {
+    ALLCLICKS *ac;
+    int32 i;		//next click
+    int32 b;		//its base
+} CLICKITER;
+
+void initALLCLICKS(ALLCLICKS *ac);
+void freeALLCLICKS(ALLCLICKS *ac);
+void allClicksAdd(ALLCLICKS *ac, double timeE, float timeS);
+void appendClicks(ALLCLICKS *ac, FILECLICKS *fc, double fileTimeE);
+void clickIterStart(CLICKITER *it, ALLCLICKS *ac, int32 i);
+int clickIterNext(CLICKITER *it, double *pTimeD);
+double allClicksTimeD(ALLCLICKS *ac, int32 i);
+void sortALLCLICKS(ALLCLICKS *ac);
+int32 allClicksFirstAfter(ALLCLICKS *ac, double tD, int orEqual);
+void writeALLCLICKS(ALLCLICKS *ac, char *filename);
+
+#endif	/* _ALLCLICKS_H_ */
@@ -0,0 +1,121 @@
+
+#include "erma.h"
+
+/* This module writes and reads the binary all_dets file. See allDetsBin.h for
+ * its layout.
+ */
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "allDetsBin.c writes numbers in the machine's order, which must be LE"
+#endif
+
+#define PAD8(n)		(((n) + 7) & ~(size_t)7)
+
+
+/* Return the size of a block of nClick clicks from a file named nameLen long,
+ * with or without spectra.
+ */
+static size_t blockSize(uint32 nClick, uint32 nameLen, uint32 specLen)
+{
+    return sizeof(ALLDETSHEAD) + PAD8(nameLen)
+	+ 3 * PAD8(nClick * sizeof(float))
+	+ PAD8((size_t)nClick * specLen);
+}
+
+
+/* Point the fields of b at the columns of the block whose head is at p. */
+static void setColumns(ALLDETSBLOCK *b, uint8_t *p)
+{
+    ALLDETSHEAD *h = (ALLDETSHEAD *)p;
+    size_t nc = h->nClick;
+
+    b->head = h;
+    p += h->headSize;
+    b->name = (char *)p;
+    p += PAD8(h->nameLen);
+    b->timeS = (float *)p;
+    p += PAD8(nc * sizeof(float));
+    b->ratioPk = (float *)p;
+    p += PAD8(nc * sizeof(float));
+    b->numerPk = (float *)p;
+    p += PAD8(nc * sizeof(float));
+    b->spec = (h->flags & ADB_SPECTRA) ? p : NULL;
+}
+
+
+/* Append the clicks found in one file, which are in fc, to the binary all_dets
+ * file at path. fileTimeE is the start time of the file, and inPath is its
+ * name. If spectra is set, the clicks' spectra go in too. The block is made in
+ * memory and goes to path by way of the journal (see journal.h), just like the
+ * all_dets CSV lines. If path is "", there's no binary all_dets file and this
+ * does nothing.
+ */
+void allDetsBinAppend(char *path, char *inPath, FILECLICKS *fc,
+		      double fileTimeE, int spectra)
+{
+    static uint8_t *blk = NULL;
+    static size_t blkSize = 0;
+
+    if (path[0] == '\0' || fc->n == 0)
+	return;
+    char *name = pathFile(inPath);
+    uint32 nameLen = strlen(name);
+    uint32 specLen = spectra ? SPECLEN : 0;
+    uint32 nc = fc->n;
+    size_t n = blockSize(nc, nameLen, specLen);
+    BUFGROW(blk, n, ERMA_NO_MEMORY_ALLDETSBIN);
+    memset(blk, 0, n);
+
+    ALLDETSHEAD *h = (ALLDETSHEAD *)blk;
+    memcpy(h->magic, ALLDETSBIN_MAGIC, 4);
+    h->headSize = sizeof(ALLDETSHEAD);
+    h->blockSize = n;
+    h->nClick = nc;
+    h->nameLen = nameLen;
+    h->flags = spectra ? ADB_SPECTRA : 0;
+    h->specLen = specLen;
+    h->specDbMin = SPEC_DB_MIN;
+    h->specDbStep = SPEC_DB_STEP;
+    h->fileTimeE = fileTimeE;
+
+    ALLDETSBLOCK b;
+    setColumns(&b, blk);
+    memcpy(b.name, name, nameLen);
+    memcpy(b.timeS, fc->timeS, nc * sizeof(float));
+    memcpy(b.ratioPk, fc->ratioPk, nc * sizeof(float));
+    memcpy(b.numerPk, fc->numerPk, nc * sizeof(float));
+    if (spectra)
+	memcpy(b.spec, fc->spec, (size_t)nc * SPECLEN);
+    h->check = fnv1a(&h->headSize, n - offsetof(ALLDETSHEAD, headSize));
+
+    journalAppend(path, blk, n);
+}
+
+
+/* Find the block at byte *pPos in buf, the n-byte contents of a binary all_dets
+ * file, and set b to point at its columns. buf must be 8-byte aligned, as what
+ * malloc and mmap return is. *pPos is moved on to the next block. Returns 1 if
+ * a block was found, or 0 at the end of buf or if the block there is bad (in
+ * which case *pPos is left at it).
+ */
+int allDetsBinNext(void *buf, size_t n, size_t *pPos, ALLDETSBLOCK *b)
+{
+    uint8_t *p = (uint8_t *)buf + *pPos;
+    size_t left = n - *pPos;
+    ALLDETSHEAD *h = (ALLDETSHEAD *)p;
+
+    if (left < sizeof(ALLDETSHEAD) || memcmp(h->magic, ALLDETSBIN_MAGIC, 4)
+	|| h->headSize < sizeof(ALLDETSHEAD) || h->headSize % 8 != 0
+	|| h->blockSize > left || h->blockSize % 8 != 0
+	|| h->blockSize != blockSize(h->nClick, h->nameLen,
+				     (h->flags & ADB_SPECTRA) ? h->specLen : 0)
+				 - sizeof(ALLDETSHEAD) + h->headSize)
+	return 0;
+    if (fnv1a(&h->headSize, h->blockSize - offsetof(ALLDETSHEAD, headSize))
+	!= h->check)
+	return 0;
+
+    setColumns(b, p);
+    *pPos += h->blockSize;
+    return 1;
+}
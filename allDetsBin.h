@@ -0,0 +1,60 @@
+#ifndef _ALLDETSBIN_H_
+#define _ALLDETSBIN_H_
+
+/* The binary all_dets file holds the same clicks as the all_dets CSV file, but
+ * in fixed-width columns, so that mission analysis can read millions of clicks
+ * without parsing millions of ASCII numbers. It's made of blocks, normally one
+ * per input file, each standing on its own:
+ *
+ *	ALLDETSHEAD	head
+ *	char		name[nameLen]		the input file's name
+ *	float		timeS[nClick]		click time in the file, s
+ *	float		ratioPk[nClick]		ratio at the click's peak
+ *	float		numerPk[nClick]		numerator power at the peak
+ *	uint8_t		spec[nClick][specLen]	spectra, if ADB_SPECTRA
+ *
+ * with each column padded with 0's to a multiple of 8 bytes, so that every
+ * column is aligned when the file is mmap'ed or read into memory. The times
+ * are the floats the clicks were found at (FILECLICKS.timeS), so they give the
+ * same CSV, to the last digit, as ErmaMain writes from them. The spectra are
+ * quantized dB as in CLICKSPEC (see ermaNew.h). The name column is a block's
+ * "file table": a block's clicks all came from one file, and there's one block
+ * per file.
+ *
+ * Numbers are little-endian, which is what the Pi and the shore computers use,
+ * so they're written in the machine's own byte order. "ermaExport" turns the
+ * file back into the CSV.
+ */
+#define ALLDETSBIN_MAGIC	"EDB2"
+#define ADB_SPECTRA	1	//flag: the block has the spec column
+
+typedef struct {
+    char magic[4];	//ALLDETSBIN_MAGIC
+    uint32 check;	//checksum of the rest of the block, from headSize on
+    uint32 headSize;	//sizeof(ALLDETSHEAD), so fields can be added later
+    uint32 blockSize;	//bytes in the whole block, head included
+    uint32 nClick;	//number of clicks
+    uint32 nameLen;	//length of the file name, without a '\0'
+    uint32 flags;	//ADB_SPECTRA
+    uint32 specLen;	//points per spectrum; 0 if there's no spec column
+    float specDbMin;	//dB of a stored spectrum value of 0...
+    float specDbStep;	//...and dB per step of a stored value
+    double fileTimeE;	//start time of the input file, s since the Epoch
+} ALLDETSHEAD;
+
+/* One block found by allDetsBinNext. The pointers point into the caller's
+ * copy of the file. */
+typedef struct {
+    ALLDETSHEAD *head;
+    char *name;		//not '\0'-terminated; head->nameLen long
+    float *timeS;
+    float *ratioPk;
+    float *numerPk;
+    uint8_t *spec;	//NULL if the block has no spectra
+} ALLDETSBLOCK;
+
+void allDetsBinAppend(char *path, char *inPath, FILECLICKS *fc,
+		      double fileTimeE, int spectra);
+int allDetsBinNext(void *buf, size_t n, size_t *pPos, ALLDETSBLOCK *b);
+
+#endif	/* _ALLDETSBIN_H_ */
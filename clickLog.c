@@ -0,0 +1,540 @@
+
+#include "erma.h"
+
+/* The binary click log: appending each file's clicks to it, reading it back
+ * with mmap, and the "ErmaMain -clicklog" query tool. See clickLog.h for the
+ * file layout.
+ */
+
+
+/* Return the size the log should have when it has nRec records. */
+static off_t logSize(int64 nRec)
+{
+    int64 nIdx = (nRec + CLICKLOG_INDEX_EVERY - 1) / CLICKLOG_INDEX_EVERY;
+    return sizeof(CLICKLOGHEAD) + nRec * sizeof(CLICKREC) +
+	nIdx * sizeof(int64) + sizeof(CLICKLOGFOOT);
+}
+
+
+static int headOK(CLICKLOGHEAD *h)
+{
+    return !memcmp(h->magic, CLICKLOG_MAGIC, 8) &&
+	h->version == CLICKLOG_VERSION && h->recSize == sizeof(CLICKREC) &&
+	h->indexEvery == CLICKLOG_INDEX_EVERY && h->nRec >= 0 &&
+	h->check == fnv1a(h, offsetof(CLICKLOGHEAD, check));
+}
+
+
+/* Return 1 if f is a good footer for a log that's fileSize bytes long. */
+static int footOK(CLICKLOGFOOT *f, off_t fileSize)
+{
+    return !memcmp(f->magic, CLICKLOG_FOOT_MAGIC, 8) &&
+	f->check == fnv1a(f, offsetof(CLICKLOGFOOT, check)) &&
+	f->nRec >= 0 && logSize(f->nRec) == fileSize;
+}
+
+
+#ifdef CLICKLOG_MAIN
+/* For the test at the bottom: putBytes "crashes" once it has written this many
+ * more bytes, writing only part of what it was asked to if need be. */
+static int64 testBytesLeft = -1;
+#endif
+
+
+/* Write all n bytes at p to offset off in fd. Return 0 if it worked. */
+static int putBytes(int fd, void *p, size_t n, off_t off)
+{
+#ifdef CLICKLOG_MAIN
+    if (testBytesLeft >= 0 && (int64)n > testBytesLeft) {
+	if (testBytesLeft > 0 && pwrite(fd, p, testBytesLeft, off)) {}
+	testBytesLeft = 0;
+	return 1;
+    }
+    if (testBytesLeft >= 0)
+	testBytesLeft -= n;
+#endif
+    while (n > 0) {
+	ssize_t k = pwrite(fd, p, n, off);
+	if (k <= 0)
+	    return 1;
+	p = (char *)p + k;
+	n -= k;
+	off += k;
+    }
+    return 0;
+}
+
+
+/* Add name to the ".files" list for the log in path, which is namesLen bytes
+ * long when committed; anything after that is from an append that didn't
+ * finish, and is cut off. Return 0 if it worked.
+ */
+static int addFileName(char *path, char *name, int64 namesLen)
+{
+    char namesPath[strlen(path) + 7];
+    snprintf(namesPath, sizeof(namesPath), "%s.files", path);
+
+    char ln[strlen(name) + 2];
+    snprintf(ln, sizeof(ln), "%s\n", name);
+    int fd = open(namesPath, O_RDWR | O_CREAT, 0666);
+    struct stat st;
+    int bad = (fd < 0 || fstat(fd, &st) != 0 || st.st_size < namesLen ||
+	       ftruncate(fd, namesLen) || putBytes(fd, ln, strlen(ln), namesLen)
+	       || fsync(fd));
+    if (fd >= 0)
+	bad |= (close(fd) != 0);
+    return bad;
+}
+
+
+/* Append the clicks in fc, from the file inPath that starts at fileTimeE
+ * (seconds since the Epoch), to the click log in path, creating it if need
+ * be. If path is "", there's no log. The file's name goes in the ".files" list
+ * first, then the new records, then the index and the footer that commit them,
+ * then the header's copy of the counts, with an fsync after each. New records
+ * go after the committed ones, so a power cut at any point leaves the count,
+ * the records it covers and the file names as they were before or after. The
+ * index is the one thing that can be left wrong, when new records went over it
+ * but not over the footer; its checksum then doesn't match, so readers don't
+ * use it and the next append makes it again from the records. Trouble
+ * writing the log is reported but otherwise ignored, as it's not needed for
+ * the rest of the processing.
+ *
+ * That's four fsyncs for each file, which is why the log is off by default.
+ */
+void clickLogAppend(char *path, char *inPath, FILECLICKS *fc,
+		    double fileTimeE)
+{
+    static CLICKREC *rec = NULL;
+    static size_t recSize = 0;
+    static int64 *idx = NULL;
+    static size_t idxSize = 0;
+
+    if (path[0] == '\0' || fc->n == 0)
+	return;
+    int fd = open(path, O_RDWR | O_CREAT, 0666);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+	fprintf(stderr, "Can't open click log %s\n", path);
+	if (fd >= 0)
+	    close(fd);
+	return;
+    }
+
+    /* Find how many records and file names are committed, from the footer if
+     * it's good and otherwise from the header. The header is only written
+     * when the footer is good, except for a new log, so one of them is. */
+    CLICKLOGHEAD h;
+    CLICKLOGFOOT f;
+    int bad = 0;
+    int haveHead = (st.st_size >= (off_t)sizeof(h) &&
+		    pread(fd, &h, sizeof(h), 0) == sizeof(h) && headOK(&h));
+    int haveFoot = (st.st_size >= (off_t)(sizeof(h) + sizeof(f)) &&
+		    pread(fd, &f, sizeof(f), st.st_size - sizeof(f)) ==
+		    sizeof(f) && footOK(&f, st.st_size) &&
+		    (!haveHead || f.nRec >= h.nRec));
+    if (!haveHead && !haveFoot && st.st_size >= (off_t)sizeof(h)) {
+	fprintf(stderr, "%s isn't a click log; not adding to it\n", path);
+	close(fd);
+	return;
+    }
+    if (!haveHead) {			//new log, or a half-written header
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, CLICKLOG_MAGIC, 8);
+	h.version = CLICKLOG_VERSION;
+	h.recSize = sizeof(CLICKREC);
+	h.indexEvery = CLICKLOG_INDEX_EVERY;
+	h.sorted = 1;
+	h.check = fnv1a(&h, offsetof(CLICKLOGHEAD, check));
+	if (!haveFoot)
+	    bad = putBytes(fd, &h, sizeof(h), 0) || fsync(fd);
+    }
+    int64 nRec = haveFoot ? f.nRec : h.nRec;
+    int sorted = haveFoot ? f.sorted : h.sorted;
+    int64 namesLen = haveFoot ? f.namesLen : h.namesLen;
+    uint32 nNames = haveFoot ? f.nNames : h.nNames;
+
+    /* Get the index, making it again from the records if it was lost or
+     * doesn't match its checksum, and the time of the last record. */
+    off_t recOff = sizeof(h);
+    int64 nIdx = (nRec + CLICKLOG_INDEX_EVERY - 1) / CLICKLOG_INDEX_EVERY;
+    int64 nNew = fc->n;
+    BUFGROW(idx, (nRec + nNew) / CLICKLOG_INDEX_EVERY + 1,
+	    ERMA_NO_MEMORY_CLICKLOG);
+    BUFGROW(rec, nNew, ERMA_NO_MEMORY_CLICKLOG);
+    off_t idxOff = recOff + nRec * sizeof(CLICKREC);
+    if (!haveFoot || pread(fd, idx, nIdx * sizeof(int64), idxOff) !=
+	(ssize_t)(nIdx * sizeof(int64)) ||
+	fnv1a(idx, nIdx * sizeof(int64)) != f.idxCheck)
+	for (int64 k = 0; k < nIdx; k++)
+	    bad |= (pread(fd, &idx[k], sizeof(int64), recOff + k *
+			  CLICKLOG_INDEX_EVERY * sizeof(CLICKREC)) !=
+		    sizeof(int64));
+    int64 lastTick = INT64_MIN;
+    if (nRec > 0)
+	bad |= (pread(fd, &lastTick, sizeof(int64), idxOff - sizeof(CLICKREC))
+		!= sizeof(int64));
+
+    /* Make the new records and index entries. */
+    char *name = pathFile(inPath);
+    uint32 fileId = nNames;
+    int64 tick0 = llround(fileTimeE * CLICK_TICKS_PER_S);
+    for (int64 i = 0; i < nNew; i++) {
+	rec[i].tick = tick0 + llround((double)fc->timeS[i] * CLICK_TICKS_PER_S);
+	rec[i].fileId = fileId;
+	rec[i].spec = -1;
+	if (rec[i].tick < lastTick)
+	    sorted = 0;
+	lastTick = rec[i].tick;
+	if ((nRec + i) % CLICKLOG_INDEX_EVERY == 0)
+	    idx[nIdx++] = rec[i].tick;
+    }
+
+    /* Write them, and commit them. */
+    bad = bad || addFileName(path, name, namesLen);
+    bad = bad || putBytes(fd, rec, nNew * sizeof(CLICKREC), idxOff) ||
+	fsync(fd);
+    nRec += nNew;
+    nNames++;
+    namesLen += strlen(name) + 1;
+    memset(&f, 0, sizeof(f));
+    memcpy(f.magic, CLICKLOG_FOOT_MAGIC, 8);
+    f.nRec = nRec;
+    f.namesLen = namesLen;
+    f.nNames = nNames;
+    f.sorted = sorted;
+    f.idxCheck = fnv1a(idx, nIdx * sizeof(int64));
+    f.check = fnv1a(&f, offsetof(CLICKLOGFOOT, check));
+    idxOff = recOff + nRec * sizeof(CLICKREC);
+    bad = bad || putBytes(fd, idx, nIdx * sizeof(int64), idxOff) ||
+	putBytes(fd, &f, sizeof(f), idxOff + nIdx * sizeof(int64)) ||
+	ftruncate(fd, logSize(nRec)) || fsync(fd);
+    h.nRec = nRec;
+    h.namesLen = namesLen;
+    h.nNames = nNames;
+    h.sorted = sorted;
+    h.check = fnv1a(&h, offsetof(CLICKLOGHEAD, check));
+    bad = bad || putBytes(fd, &h, sizeof(h), 0) || fsync(fd);
+    if (close(fd) != 0 || bad)
+	fprintf(stderr, "Can't add to click log %s\n", path);
+}
+
+
+/* Open the click log in path for reading. Return 1 if it worked, or 0 if it's
+ * not there or not a click log.
+ */
+int clickLogOpen(CLICKLOG *cl, char *path)
+{
+    memset(cl, 0, sizeof(*cl));
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0)
+	return 0;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CLICKLOGHEAD)) {
+	close(fd);
+	return 0;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);				//the mapping stays
+    if (map == MAP_FAILED)
+	return 0;
+    cl->map = map;
+    cl->mapLen = st.st_size;
+
+    CLICKLOGHEAD *h = map;
+    CLICKLOGFOOT *f = (CLICKLOGFOOT *)((char *)map + st.st_size - sizeof(*f));
+    int haveHead = headOK(h);
+    cl->rec = (CLICKREC *)(h + 1);
+    if (st.st_size >= (off_t)(sizeof(*h) + sizeof(*f)) &&
+	footOK(f, st.st_size) && (!haveHead || f->nRec >= h->nRec)) {
+	cl->nRec = f->nRec;
+	cl->sorted = f->sorted;
+	cl->idx = (int64 *)&cl->rec[cl->nRec];
+	cl->nIdx = (cl->nRec + CLICKLOG_INDEX_EVERY-1) / CLICKLOG_INDEX_EVERY;
+	if (fnv1a(cl->idx, cl->nIdx * sizeof(int64)) != f->idxCheck) {
+	    cl->idx = NULL;		//overwritten by an unfinished append
+	    cl->nIdx = 0;
+	}
+    } else if (haveHead &&
+	       sizeof(*h) + h->nRec * sizeof(CLICKREC) <= (size_t)st.st_size) {
+	cl->nRec = h->nRec;		//the last append didn't finish
+	cl->sorted = h->sorted;
+    } else {
+	clickLogClose(cl);
+	return 0;
+    }
+    return 1;
+}
+
+
+void clickLogClose(CLICKLOG *cl)
+{
+    if (cl->map != NULL)
+	munmap(cl->map, cl->mapLen);
+    memset(cl, 0, sizeof(*cl));
+}
+
+
+/* Return the number of the first record in cl whose time is at or after tick,
+ * or cl->nRec if there's none. The records must be sorted (cl->sorted). The
+ * index is searched first, so only one stretch of CLICKLOG_INDEX_EVERY records
+ * is searched after that.
+ */
+int64 clickLogFirstAtOrAfter(CLICKLOG *cl, int64 tick)
+{
+    int64 lo = 0, hi = cl->nRec;
+    if (cl->idx != NULL) {
+	int64 a = 0, b = cl->nIdx;	//first k with idx[k] >= tick
+	while (a < b) {
+	    int64 mid = a + (b - a) / 2;
+	    if (cl->idx[mid] < tick)
+		a = mid + 1;
+	    else
+		b = mid;
+	}
+	lo = MAX(0, a - 1) * CLICKLOG_INDEX_EVERY;
+	hi = MIN(cl->nRec, a * CLICKLOG_INDEX_EVERY);
+    }
+    while (lo < hi) {
+	int64 mid = lo + (hi - lo) / 2;
+	if (cl->rec[mid].tick < tick)
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+
+/* Return the number of clicks in cl at or after tick0 and before tick1. */
+int64 clickLogCount(CLICKLOG *cl, int64 tick0, int64 tick1)
+{
+    if (cl->sorted)
+	return MAX(0, clickLogFirstAtOrAfter(cl, tick1) -
+		   clickLogFirstAtOrAfter(cl, tick0));
+    int64 n = 0;
+    for (int64 i = 0; i < cl->nRec; i++)
+	n += (cl->rec[i].tick >= tick0 && cl->rec[i].tick < tick1);
+    return n;
+}
+
+
+/* Parse a time given as yymmdd-HHMMSS, as in the output files, or as seconds
+ * since the Epoch, into *pTick. Return 1 if it worked.
+ */
+static int parseTime(char *s, int64 *pTick)
+{
+    struct tm tm;
+    double e;
+    char extra;
+
+    memset(&tm, 0, sizeof(tm));
+    if (sscanf(s, "%2d%2d%2d-%2d%2d%2d%c", &tm.tm_year, &tm.tm_mon,
+	       &tm.tm_mday, &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &extra) == 6) {
+	tm.tm_year += 100;		//years since 1900
+	tm.tm_mon--;
+	*pTick = (int64)my_timegm(&tm) * CLICK_TICKS_PER_S;
+	return 1;
+    }
+    if (sscanf(s, "%lf%c", &e, &extra) == 1) {
+	*pTick = llround(e * CLICK_TICKS_PER_S);
+	return 1;
+    }
+    return 0;
+}
+
+
+/* "ErmaMain -clicklog logFile [from to [binS]]": say how many clicks are in
+ * the log and what times they span, and if from and to are given, how many
+ * are at or after from and before to. If binS is given too, the count in each
+ * binS-second bin from then on is printed, as "yymmdd-HHMMSS,count" lines.
+ * args has the nArgs arguments after "-clicklog".
+ */
+int clickLogMain(int nArgs, char **args)
+{
+    CLICKLOG cl;
+    char buf0[20], buf1[20];
+    int64 t0, t1;
+    double binS = 0;
+
+    if (nArgs < 1 || nArgs == 2 || nArgs > 4 ||
+	(nArgs >= 3 && (!parseTime(args[1], &t0) || !parseTime(args[2], &t1)))
+	|| (nArgs == 4 && (sscanf(args[3], "%lf", &binS) != 1 || binS <= 0))) {
+	fprintf(stderr, "Usage: ErmaMain -clicklog logFile [from to [binS]]\n"
+		"  from and to are yymmdd-HHMMSS or seconds since 1970.\n");
+	return ERMA_CLICKLOG_BAD_ARGS;
+    }
+    if (!clickLogOpen(&cl, args[0])) {
+	fprintf(stderr, "Can't read click log %s\n", args[0]);
+	return ERMA_CLICKLOG_BAD_ARGS;
+    }
+
+    int64 minTick = INT64_MAX, maxTick = INT64_MIN;
+    if (cl.sorted && cl.nRec > 0) {
+	minTick = cl.rec[0].tick;
+	maxTick = cl.rec[cl.nRec - 1].tick;
+    } else
+	for (int64 i = 0; i < cl.nRec; i++) {
+	    minTick = MIN(minTick, cl.rec[i].tick);
+	    maxTick = MAX(maxTick, cl.rec[i].tick);
+	}
+    printf("%s: %lld clicks", args[0], (long long)cl.nRec);
+    if (cl.nRec > 0)
+	printf(" from %s to %s", timeStrE(buf0, minTick / CLICK_TICKS_PER_S),
+	       timeStrE(buf1, maxTick / CLICK_TICKS_PER_S));
+    printf("%s%s\n", cl.sorted ? "" : " (not in time order)",
+	   cl.idx ? "" : " (last append unfinished; no index)");
+
+    if (nArgs >= 3 && binS == 0)
+	printf("%lld clicks from %s to %s\n",
+	       (long long)clickLogCount(&cl, t0, t1), timeStrE(buf0, t0 /
+	       CLICK_TICKS_PER_S), timeStrE(buf1, t1 / CLICK_TICKS_PER_S));
+    if (binS > 0) {
+	int64 binTicks = llround(binS * CLICK_TICKS_PER_S);
+	for (int64 b = t0; b < t1; b += binTicks)
+	    printf("%s,%lld\n", timeStrE(buf0, b / CLICK_TICKS_PER_S),
+		   (long long)clickLogCount(&cl, b, MIN(b + binTicks, t1)));
+    }
+    clickLogClose(&cl);
+    return 0;
+}
+/**********************************************************************/
+
+
+/* This tests that a power cut part way through clickLogAppend can't spoil the
+ * log. A log of 3000 clicks from two files has a third file appended to it,
+ * of 5 clicks (few enough that the old footer survives) or of 300, with the
+ * writes stopping for good after each possible number of bytes. Each time,
+ * the log must read back as it was before or after, with any index it has
+ * matching the records, and one more append must then leave it with the right
+ * clicks, index, and file names. Every stopped append says it can't add to
+ * the log, so run it with 2>/dev/null. Compile with
+ *
+ *	cc -O2 -DCLICKLOG_MAIN -include erma.h clickLog.c ermaGoodies.c -lm
+ */
+#ifdef CLICKLOG_MAIN
+#define TEST_LOG	"/tmp/clickLogTest"
+static int64 expTick[4000];	//what the log should have
+static uint32 expId[4000];
+
+/* Make n clicks in *fc, and put what the log should get for them in expTick
+ * and expId from [at] on. */
+static void testClicks(FILECLICKS *fc, int n, double fileTimeE, uint32 id,
+		       int64 at)
+{
+    BUFGROW(fc->timeS, n, ERMA_NO_MEMORY_CLICKLOG);
+    fc->n = n;
+    for (int i = 0; i < n; i++) {
+	fc->timeS[i] = 0.01f * i + 0.0000137f * (i % 7);
+	expTick[at + i] = llround(fileTimeE * CLICK_TICKS_PER_S) +
+	    llround((double)fc->timeS[i] * CLICK_TICKS_PER_S);
+	expId[at + i] = id;
+    }
+}
+
+
+/* Check that the log has nA or nB of the clicks in expTick, and any index it
+ * has is right. Return the number it has, or -1 if it's wrong. */
+static int64 testCheck(int64 nA, int64 nB)
+{
+    CLICKLOG cl;
+    if (!clickLogOpen(&cl, TEST_LOG))
+	return -1;
+    int ok = (cl.nRec == nA || cl.nRec == nB) && cl.sorted;
+    for (int64 i = 0; ok && i < cl.nRec; i++)
+	ok = (cl.rec[i].tick == expTick[i] && cl.rec[i].fileId == expId[i]);
+    if (ok && cl.idx != NULL) {
+	ok = (cl.nIdx == (cl.nRec + CLICKLOG_INDEX_EVERY - 1) /
+	      CLICKLOG_INDEX_EVERY);
+	for (int64 k = 0; ok && k < cl.nIdx; k++)
+	    ok = (cl.idx[k] == cl.rec[k * CLICKLOG_INDEX_EVERY].tick);
+    }
+    int64 n = ok ? cl.nRec : -1;
+    clickLogClose(&cl);
+    return n;
+}
+
+
+static void testCopy(char *from, char *to)
+{
+    char buf[1 << 16];
+    FILE *in = fopen(from, "rb"), *out = fopen(to, "wb");
+    size_t n;
+    while (in != NULL && (n = fread(buf, 1, sizeof(buf), in)) > 0)
+	fwrite(buf, 1, n, out);
+    if (in != NULL)
+	fclose(in);
+    fclose(out);
+}
+
+
+int main(int argc, char **argv)
+{
+    FILECLICKS fc;
+    int nNew[] = { 5, 300 };
+    int nBad = 0;
+
+    memset(&fc, 0, sizeof(fc));
+    unlink(TEST_LOG);
+    unlink(TEST_LOG ".files");
+    testClicks(&fc, 2000, 1.5e9, 0, 0);
+    clickLogAppend(TEST_LOG, "/data/f0.wav", &fc, 1.5e9);
+    testClicks(&fc, 1000, 1.5e9 + 100, 1, 2000);
+    clickLogAppend(TEST_LOG, "/data/f1.wav", &fc, 1.5e9 + 100);
+    if (testCheck(3000, 3000) != 3000) {
+	printf("the log wasn't made right\n");
+	return 1;
+    }
+    testCopy(TEST_LOG, TEST_LOG ".0");
+    testCopy(TEST_LOG ".files", TEST_LOG ".files.0");
+
+    for (int j = 0; j < NUM_OF(nNew); j++) {
+	int64 nB = 3000 + nNew[j], nTries = 0, nLost = 0;
+	testCopy(TEST_LOG ".0", TEST_LOG);		//find the bytes written
+	testCopy(TEST_LOG ".files.0", TEST_LOG ".files");
+	testClicks(&fc, nNew[j], 1.5e9 + 200, 2, 3000);
+	testBytesLeft = INT64_MAX / 2;
+	clickLogAppend(TEST_LOG, "/data/f2.wav", &fc, 1.5e9 + 200);
+	int64 nBytes = INT64_MAX / 2 - testBytesLeft;
+
+	for (int64 k = 0; k <= nBytes; k++, nTries++) {
+	    testCopy(TEST_LOG ".0", TEST_LOG);
+	    testCopy(TEST_LOG ".files.0", TEST_LOG ".files");
+	    testClicks(&fc, nNew[j], 1.5e9 + 200, 2, 3000);
+	    testBytesLeft = k;
+	    clickLogAppend(TEST_LOG, "/data/f2.wav", &fc, 1.5e9 + 200);
+	    testBytesLeft = -1;
+	    int64 n = testCheck(3000, nB);
+	    nLost += (n == 3000);
+
+	    //Another append has to finish the job.
+	    uint32 id = (n == nB) ? 3 : 2;
+	    int64 at = (n == nB) ? nB : 3000;
+	    testClicks(&fc, 7, 1.5e9 + 300, id, at);
+	    clickLogAppend(TEST_LOG, "/data/f3.wav", &fc, 1.5e9 + 300);
+	    int ok = (n >= 0 && testCheck(at + 7, at + 7) == at + 7);
+	    FILE *fp = fopen(TEST_LOG ".files", "r");
+	    char names[200];
+	    size_t len = fp ? fread(names, 1, sizeof(names) - 1, fp) : 0;
+	    names[len] = 0;
+	    if (fp)
+		fclose(fp);
+	    ok = ok && !strcmp(names, (n == nB) ?
+			       "f0.wav\nf1.wav\nf2.wav\nf3.wav\n" :
+			       "f0.wav\nf1.wav\nf3.wav\n");
+	    if (!ok && nBad++ < 10)
+		printf("appending %d clicks, stopped after %lld bytes: wrong\n",
+		       nNew[j], (long long)k);
+	}
+	printf("appending %d clicks: %lld stopping points, %lld lost the "
+	       "append\n", nNew[j], (long long)nTries, (long long)nLost);
+    }
+    unlink(TEST_LOG);
+    unlink(TEST_LOG ".files");
+    unlink(TEST_LOG ".0");
+    unlink(TEST_LOG ".files.0");
+    printf(nBad ? "%d FAILED\n" : "all OK\n", nBad);
+    return nBad != 0;
+}
+#endif	/* CLICKLOG_MAIN */
+/**********************************************************************/
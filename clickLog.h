@@ -0,0 +1,90 @@
+#ifndef _CLICKLOG_H_
+#define _CLICKLOG_H_
+
+/* The click log is a binary file that every click found is appended to, run
+ * after run, so that the clicks can be looked up by time without re-reading
+ * the all_dets text files. It's laid out as
+ *
+ *	CLICKLOGHEAD	header
+ *	CLICKREC	rec[nRec]	one per click, in the order found
+ *	int64		idx[nIdx]	time of every CLICKLOG_INDEX_EVERY'th rec
+ *	CLICKLOGFOOT	footer
+ *
+ * where nIdx = ceil(nRec / CLICKLOG_INDEX_EVERY). The records have a fixed
+ * size, so a reader can mmap the file and go straight to any one of them, and
+ * since files are normally processed in time order, the records are normally
+ * in time order too and a time range can be found with a binary search, using
+ * the sparse index idx to narrow it down to one stretch of records first.
+ *
+ * Appending new clicks overwrites the old index and footer, so the footer is
+ * written only after the new records are on the disk, and it's what says how
+ * many records there are: a footer that's there and checks out means all the
+ * records before it are good. The index can still have been overwritten by new
+ * records when the footer wasn't (when they fit in the space it took), so the
+ * footer has a checksum of the index too, and an index that doesn't match it
+ * isn't used; an append makes it again from the records. The header has a copy
+ * of the footer's counts that's updated last, for when a power cut leaves the
+ * footer half-written.
+ *
+ * File ids are line numbers (from 0) in a text file named like the log with
+ * ".files" on the end, which has the name of each file clicks came from. The
+ * footer and header say how many names it has and how long it is, so the next
+ * id is known without reading it, and a name added by an append that didn't
+ * finish is cut off by the next one.
+ *
+ * Numbers are stored in the machine's own byte order; the Pi and the shore
+ * computers are all little-endian.
+ */
+#define CLICKLOG_MAGIC		"ERMACLOG"
+#define CLICKLOG_FOOT_MAGIC	"ERMAEND1"
+#define CLICKLOG_VERSION	2
+#define CLICKLOG_INDEX_EVERY	256	//records per index entry: 4 KB of them
+
+typedef struct {
+    char magic[8];	//CLICKLOG_MAGIC
+    uint32 version;	//CLICKLOG_VERSION
+    uint32 recSize;	//sizeof(CLICKREC)
+    uint32 indexEvery;	//CLICKLOG_INDEX_EVERY
+    uint32 sorted;	//copy of the footer's sorted
+    int64 nRec;		//copy of the footer's nRec, maybe out of date
+    int64 namesLen;	//copy of the footer's namesLen
+    uint32 nNames;	//copy of the footer's nNames
+    uint32 check;	//checksum of the fields above
+} CLICKLOGHEAD;
+
+typedef struct {
+    int64 tick;		//click time, 1/CLICK_TICKS_PER_S s since the Epoch
+    uint32 fileId;	//line number in the ".files" file
+    int32 spec;		//spectrum handle; -1, as spectra aren't logged yet
+} CLICKREC;
+
+typedef struct {
+    char magic[8];	//CLICKLOG_FOOT_MAGIC
+    int64 nRec;		//number of records
+    int64 namesLen;	//length of the ".files" file
+    uint32 nNames;	//number of names in it, which is the next file id
+    uint32 sorted;	//1 if the records are in time order
+    uint32 idxCheck;	//checksum of the index
+    uint32 check;	//checksum of the fields above
+} CLICKLOGFOOT;
+
+/* A click log opened for reading with clickLogOpen. */
+typedef struct {
+    void *map;		//the whole file, mmap'ed
+    size_t mapLen;
+    CLICKREC *rec;	//the records
+    int64 nRec;
+    int64 *idx;		//the sparse index, or NULL if it was lost
+    int64 nIdx;
+    int sorted;
+} CLICKLOG;
+
+void clickLogAppend(char *path, char *inPath, FILECLICKS *fc,
+		    double fileTimeE);
+int clickLogOpen(CLICKLOG *cl, char *path);
+void clickLogClose(CLICKLOG *cl);
+int64 clickLogFirstAtOrAfter(CLICKLOG *cl, int64 tick);
+int64 clickLogCount(CLICKLOG *cl, int64 tick0, int64 tick1);
+int clickLogMain(int nArgs, char **args);
+
+#endif	/* _CLICKLOG_H_ */
@@ -0,0 +1,205 @@
+
+#include "erma.h"
+
+/* This module calculates click spectra. Rather than transforming one click at
+ * a time, the clicks found in a segment are handed over all at once. Each click
+ * is cut into a series of NFFT-long frames that overlap by half; all the frames
+ * from all the clicks are windowed and put through a real-input FFT SPEC_BATCH
+ * frames at a time, and the power in each frame is summed into its click's
+ * spectrum. The averaged spectra are stored as quantized dB (see CLICKSPEC in
+ * ermaNew.h).
+ *
+ * The real-input FFT works by packing the NFFT real samples into NFFT/2
+ * complex ones (even samples in the real part, odd in the imaginary), doing an
+ * NFFT/2-point complex FFT, and then untangling the result. This takes about
+ * half the work of the complex NFFT-point FFT in fft.c with a zero imaginary
+ * part.
+ */
+
+#define HALFN	(NFFT/2)		//size of the complex FFT
+
+/* Tables that are set up once and then re-used: the Hanning window, the
+ * bit-reversal permutation and twiddle factors for the HALFN-point complex FFT,
+ * and the twiddle factors for untangling its output into the NFFT-point real
+ * FFT.
+ */
+static float win[NFFT];
+static int32 bitRev[HALFN];
+static float twRe[HALFN/2], twIm[HALFN/2];
+static float untRe[HALFN+1], untIm[HALFN+1];
+static int tablesInitted = 0;
+
+/* Running totals for the stage timings report. */
+static double specSec = 0.0;
+static int32 specClicks = 0;
+
+
+static void initTables(void)
+{
+    fftMakeWindow(win, WIN_HANNING, NFFT, 0);
+
+    for (int32 i = 0; i < HALFN; i++) {
+	int32 r = 0;
+	for (int32 b = 1, rb = HALFN/2; b < HALFN; b <<= 1, rb >>= 1)
+	    if (i & b) r |= rb;
+	bitRev[i] = r;
+    }
+    for (int32 k = 0; k < HALFN/2; k++) {
+	twRe[k] =  cos(2*M_PI * k / HALFN);
+	twIm[k] = -sin(2*M_PI * k / HALFN);
+    }
+    for (int32 k = 0; k <= HALFN; k++) {
+	untRe[k] =  cos(2*M_PI * k / NFFT);
+	untIm[k] = -sin(2*M_PI * k / NFFT);
+    }
+    tablesInitted = 1;
+}
+
+
+/* Do HALFN-point complex FFTs on SPEC_BATCH frames at once. re[i][lane] and
+ * im[i][lane] hold sample i of each frame; the input must already be in
+ * bit-reversed order. The transform is done in place.
+ */
+static void fftBatch(float re[HALFN][SPEC_BATCH], float im[HALFN][SPEC_BATCH])
+{
+    for (int32 le1 = 1; le1 < HALFN; le1 <<= 1) {
+	int32 le = le1 << 1;
+	int32 twStep = HALFN / le;
+	for (int32 j = 0; j < le1; j++) {
+	    float ure = twRe[j * twStep], uim = twIm[j * twStep];
+	    for (int32 p = j; p < HALFN; p += le) {
+		int32 q = p + le1;
+		for (int32 l = 0; l < SPEC_BATCH; l++) {
+		    float tre = re[q][l] * ure - im[q][l] * uim;
+		    float tim = re[q][l] * uim + im[q][l] * ure;
+		    re[q][l] = re[p][l] - tre;
+		    im[q][l] = im[p][l] - tim;
+		    re[p][l] += tre;
+		    im[p][l] += tim;
+		}
+	    }
+	}
+    }
+}
+
+
+/* Calculate the spectra of nClicks clicks in seg, a signal of length nSeg.
+ * Click i is centered at sample centerIx[i], and its spectrum is the average
+ * power spectrum over the nSpecSams samples around that point, which gets put
+ * in dst[i]. Spectrum point j is the power at frequency (j+1)/NFFT * sRate, so
+ * the DC term is left out and the last point is at the Nyquist frequency.
+ */
+void clickSpecBatch(float *seg, size_t nSeg, int64_t *centerIx,
+		    int32 nClicks, size_t nSpecSams, CLICKSPEC *dst)
+{
+    static float re[HALFN][SPEC_BATCH], im[HALFN][SPEC_BATCH];
+    static int32 *frameClick = NULL;	//which click each frame belongs to
+    static int64 *frameIx = NULL;	//starting sample of each frame
+    static float *sumSpec = NULL;	//summed power spectra, SPECLEN per click
+    static int32 *nSum = NULL;		//# of frames summed for each click
+    static size_t frameClickSize = 0, frameIxSize = 0;
+    static size_t sumSpecSize = 0, nSumSize = 0;
+
+    if (nClicks <= 0)
+	return;
+    double t0 = nowSec();
+    if (!tablesInitted)
+	initTables();
+
+    /* Make the list of frames. The click's span is shifted as needed to keep
+     * it inside seg. */
+    int64 nFrames = 0;
+    for (int32 c = 0; c < nClicks; c++) {
+	int64 ix0 = centerIx[c] - (int64)nSpecSams/2;
+	int64 ix1 = ix0 + (int64)nSpecSams;
+	if (ix1 > (int64)nSeg) {
+	    ix0 -= ix1 - (int64)nSeg;
+	    ix1 = nSeg;
+	}
+	if (ix0 < 0)
+	    ix0 = 0;
+	for (int64 i = ix0; i + NFFT <= ix1; i += SPECLEN) {
+	    BUFGROW(frameClick, nFrames + 1, ERMA_NO_MEMORY_CLICKSPEC);
+	    BUFGROW(frameIx,    nFrames + 1, ERMA_NO_MEMORY_CLICKSPEC);
+	    frameClick[nFrames] = c;
+	    frameIx[nFrames] = i;
+	    nFrames++;
+	}
+    }
+    BUFGROW(sumSpec, nClicks * SPECLEN, ERMA_NO_MEMORY_CLICKSPEC);
+    BUFGROW(nSum,    nClicks,           ERMA_NO_MEMORY_CLICKSPEC);
+    memset(sumSpec, 0, nClicks * SPECLEN * sizeof(sumSpec[0]));
+    memset(nSum,    0, nClicks * sizeof(nSum[0]));
+
+    /* Transform the frames SPEC_BATCH at a time. Unused lanes in the last
+     * batch are zeroed and their results discarded. */
+    for (int64 f0 = 0; f0 < nFrames; f0 += SPEC_BATCH) {
+	int32 nLanes = MIN(SPEC_BATCH, nFrames - f0);
+
+	//Window the frames and pack them as complex samples, bit-reversed.
+	for (int32 l = 0; l < SPEC_BATCH; l++) {
+	    if (l >= nLanes) {
+		for (int32 i = 0; i < HALFN; i++)
+		    re[i][l] = im[i][l] = 0.0;
+		continue;
+	    }
+	    float *x = &seg[frameIx[f0 + l]];
+	    for (int32 i = 0; i < HALFN; i++) {
+		re[bitRev[i]][l] = x[2*i]   * win[2*i];
+		im[bitRev[i]][l] = x[2*i+1] * win[2*i+1];
+	    }
+	}
+
+	fftBatch(re, im);
+
+	//Untangle the complex FFT into the real one and sum the power of
+	//points 1..HALFN into each frame's click.
+	for (int32 k = 1; k <= HALFN; k++) {
+	    int32 kk = k & (HALFN-1), km = (HALFN - k) & (HALFN-1);
+	    float c = untRe[k], s = -untIm[k];
+	    float pw[SPEC_BATCH];
+	    for (int32 l = 0; l < SPEC_BATCH; l++) {
+		float ar = re[kk][l], ai = im[kk][l];
+		float br = re[km][l], bi = -im[km][l];	//conjugate
+		float evRe = (ar + br) * 0.5f, evIm = (ai + bi) * 0.5f;
+		float odRe = (ai - bi) * 0.5f, odIm = (br - ar) * 0.5f;
+		float xRe = evRe + c * odRe + s * odIm;
+		float xIm = evIm + c * odIm - s * odRe;
+		pw[l] = xRe * xRe + xIm * xIm;
+	    }
+	    for (int32 l = 0; l < nLanes; l++)
+		sumSpec[frameClick[f0 + l] * SPECLEN + k-1] += pw[l];
+	}
+	for (int32 l = 0; l < nLanes; l++)
+	    nSum[frameClick[f0 + l]]++;
+    }
+
+    /* Average the summed power and quantize it to dB. */
+    for (int32 c = 0; c < nClicks; c++) {
+	for (int32 j = 0; j < SPECLEN; j++) {
+	    float pw = nSum[c] ? sumSpec[c * SPECLEN + j] / nSum[c] : 0.0;
+	    float q = (pw > 0) ? (10*log10f(pw) - SPEC_DB_MIN) / SPEC_DB_STEP : 0;
+	    dst[c][j] = (uint8_t)MAX(0, MIN(255, lrintf(q)));
+	}
+    }
+
+#ifdef DEBUG_SAVE_SPECTRA
+    float lastSpec[SPECLEN];
+    for (int32 j = 0; j < SPECLEN; j++)
+	lastSpec[j] = CLICKSPEC_DB(dst[nClicks-1][j]);
+    writeFloatArray(lastSpec, SPECLEN, "temp-clickSpectrum.flt");
+#endif
+
+    specSec += nowSec() - t0;
+    specClicks += nClicks;
+}
+
+
+/* Report the total time spent calculating spectra so far, and the number of
+ * click spectra calculated in that time.
+ */
+void clickSpecGetTimes(double *pSec, int32 *pNClicks)
+{
+    *pSec = specSec;
+    *pNClicks = specClicks;
+}
@@ -0,0 +1,13 @@
+#ifndef _CLICKSPEC_H_
+#define _CLICKSPEC_H_
+
+/* Number of FFT frames that are transformed together, one per "lane". The
+ * inner loops of the batched FFT run across lanes, so the compiler can turn
+ * them into SIMD instructions. */
+#define SPEC_BATCH	8
+
+void clickSpecBatch(float *seg, size_t nSeg, int64_t *centerIx,
+		    int32 nClicks, size_t nSpecSams, CLICKSPEC *dst);
+void clickSpecGetTimes(double *pSec, int32 *pNClicks);
+
+#endif	/* _CLICKSPEC_H_ */
@@ -0,0 +1,327 @@
+
+#include "erma.h"
+
+/* This module finds the input files that haven't been processed yet. The
+ * infilePattern is a directory pattern and a file pattern, normally a
+ * directory per day ("[0-9][0-9][0-9][0-9][0-9][0-9]/") and the WISPR files in
+ * it ("*.dat"). Listing every file of every day of the mission on every boot
+ * takes longer and longer as the mission goes on, though only the newest
+ * directories have changed, so the directories are read with readdir, using
+ * d_type to tell files from directories without a stat of each, and those
+ * known to have nothing new in them are skipped without being read at all.
+ *
+ * What's known is kept in the directory-scan state file: for each directory
+ * whose input files had all been processed the last time it was read, its
+ * modification time, its size, and how many input files it had. If its
+ * modification time and size are still the same, no file has been added to or
+ * removed from it since then. The size is there as well because a FAT writer
+ * (like WISPR's) needn't update a directory's modification time when it adds a
+ * file; a directory that gets more entries than fit in its clusters grows,
+ * though. Since a file can still be added without either changing, the newest
+ * directory - the one being written to - is never put in the state file, and
+ * so is read on every boot. A directory with unprocessed files isn't put in
+ * either, as they might not all get processed (e.g., on a fast quit); it's
+ * read again on the next boot and put in then. Neither is one changed in the
+ * last DIRSCAN_SETTLE_S seconds, as on a FAT file system (like the SD card's)
+ * the modification time is only good to 2 s, so a file added just after the
+ * directory was read might not change it.
+ *
+ * Since the state file depends on files_processed, delete it too if you take
+ * names out of files_processed to get those files processed again.
+ */
+
+#define DIRSCAN_SETTLE_S	10	//see above
+#define DIRSCAN_MAGIC		"ermaDirScan"
+#define DIRSCAN_VERSION		2
+
+
+/* Return 1 if s has any glob wildcards in it. */
+static int hasWild(char *s)
+{
+    return strpbrk(s, "*?[") != NULL;
+}
+
+
+/* Return 1 if the directory entry d, which is in directory dir, is a directory
+ * (want == S_IFDIR) or a regular file (want == S_IFREG). d_type says which
+ * without a stat, except on file systems that don't fill it in, and for
+ * symbolic links, which are followed.
+ */
+static int entryIs(struct dirent *d, char *dir, mode_t want)
+{
+    if (d->d_type == DT_DIR)
+	return want == S_IFDIR;
+    if (d->d_type == DT_REG)
+	return want == S_IFREG;
+    if (d->d_type != DT_UNKNOWN && d->d_type != DT_LNK)
+	return 0;
+    char path[strlen(dir) + strlen(d->d_name) + 2];
+    struct stat st;
+    snprintf(path, sizeof(path), "%s/%s", dir, d->d_name);
+    return stat(path, &st) == 0 && (st.st_mode & S_IFMT) == want;
+}
+
+
+static int cmpDirState(const void *a, const void *b)
+{
+    return strcmp(((DIRSTATE *)a)->path, ((DIRSTATE *)b)->path);
+}
+
+
+/* Order path names by file name, which for WISPR files is by time, and then by
+ * the whole path.
+ */
+static int cmpByFileName(const void *a, const void *b)
+{
+    char *pa = *(char **)a, *pb = *(char **)b;
+    int c = strcmp(pathFile(pa), pathFile(pb));
+    return c ? c : strcmp(pa, pb);
+}
+
+
+/* Read the directory-scan state file at statePath into a new array of n
+ * DIRSTATEs sorted by path, and return it. If the file is missing, bad, or was
+ * made with a different infilePattern, there's nothing known, and n is 0.
+ */
+static DIRSTATE *readState(char *statePath, char *infilePattern, int32 *pN)
+{
+    DIRSTATE *ds = NULL;
+    size_t dsSize = 0;
+    int32 n = 0;
+    char *buf = (statePath[0] != '\0') ? readWholeFile(statePath, NULL) : NULL;
+    char *ln, *end;
+
+    /* The first line is "ermaDirScan <version> <infilePattern>"; each one
+     * after that is a directory's "<mtimeS> <mtimeNs> <size> <nFiles> <path>".
+     */
+    char head[strlen(DIRSCAN_MAGIC) + strlen(infilePattern) + 16];
+    snprintf(head, sizeof(head), "%s %d %s\n", DIRSCAN_MAGIC, DIRSCAN_VERSION,
+	     infilePattern);
+    if (buf != NULL && !strncmp(buf, head, strlen(head)))
+	ln = buf + strlen(head);
+    else
+	ln = NULL;
+    while (ln != NULL && (end = strchr(ln, '\n')) != NULL) {
+	long long mtimeS, size;
+	int32 mtimeNs, nFiles, pos = 0;
+	*end = '\0';
+	if (sscanf(ln, "%lld %d %lld %d %n", &mtimeS, &mtimeNs, &size, &nFiles,
+		   &pos) < 4 || pos == 0 || ln[pos] == '\0')
+	    break;
+	BUFGROW(ds, n + 1, ERMA_NO_MEMORY_DIRSCAN);
+	ds[n].path = strsave(ln + pos);
+	ds[n].mtimeS = mtimeS;
+	ds[n].mtimeNs = mtimeNs;
+	ds[n].size = size;
+	ds[n].nFiles = nFiles;
+	n++;
+	ln = end + 1;
+    }
+    free(buf);
+    if (n > 0)
+	qsort(ds, n, sizeof(ds[0]), cmpDirState);
+    *pN = n;
+    return ds;
+}
+
+
+/* Save the n DIRSTATEs in ds to the directory-scan state file at statePath. As
+ * with the encounter state, it's written to a temporary file first and then
+ * renamed, so a power cut leaves either the old state or the new one.
+ */
+static void writeState(char *statePath, char *infilePattern, DIRSTATE *ds,
+		       int32 n)
+{
+    char tmpPath[strlen(statePath) + 5];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", statePath);
+
+    FILE *fp = fopen(tmpPath, "w");
+    int bad = (fp == NULL);
+    if (!bad) {
+	fprintf(fp, "%s %d %s\n", DIRSCAN_MAGIC, DIRSCAN_VERSION,
+		infilePattern);
+	for (int32 i = 0; i < n; i++)
+	    fprintf(fp, "%lld %d %lld %d %s\n", (long long)ds[i].mtimeS,
+		    ds[i].mtimeNs, (long long)ds[i].size, ds[i].nFiles,
+		    ds[i].path);
+	bad = (fflush(fp) != 0 || fsync(fileno(fp)) != 0);
+	bad |= (fclose(fp) != 0);
+    }
+    if (bad || rename(tmpPath, statePath))
+	fprintf(stderr, "Can't save directory-scan state in %s\n", statePath);
+}
+
+
+/* Make a list of the directories matching the directory template templtDir,
+ * appending them to *pDirs, which has *pN in it already. The template's last
+ * part is matched against the entries of its parent directory; only if the
+ * parent has wildcards too is glob used to find them. Returns the new *pDirs.
+ */
+static char **listDirs(char *templtDir, char **dirs, size_t *pDirsSize,
+		       int32 *pN)
+{
+    size_t dirsSize = *pDirsSize;
+    int32 n = *pN;
+    char parent[strlen(templtDir) + 2];
+    pathDir(parent, templtDir);
+    char *dirPat = pathFile(templtDir);
+
+    if (hasWild(parent)) {
+	glob_t gb;
+	if (glob(templtDir, GLOB_NOESCAPE | GLOB_ONLYDIR, NULL, &gb) == 0) {
+	    for (size_t i = 0; i < gb.gl_pathc; i++) {
+		struct stat st;
+		if (stat(gb.gl_pathv[i], &st) == 0 && S_ISDIR(st.st_mode)) {
+		    BUFGROW(dirs, n + 1, ERMA_NO_MEMORY_DIRSCAN);
+		    dirs[n++] = strsave(gb.gl_pathv[i]);
+		}
+	    }
+	    globfree(&gb);
+	}
+    } else if (hasWild(dirPat)) {
+	DIR *dp = opendir(parent);
+	struct dirent *d;
+	while (dp != NULL && (d = readdir(dp)) != NULL) {
+	    if (fnmatch(dirPat, d->d_name, FNM_PERIOD) == 0
+		&& entryIs(d, parent, S_IFDIR)) {
+		BUFGROW(dirs, n + 1, ERMA_NO_MEMORY_DIRSCAN);
+		dirs[n] = malloc(strlen(parent) + strlen(d->d_name) + 2);
+		if (dirs[n] == NULL)
+		    exit(ERMA_NO_MEMORY_DIRSCAN);
+		sprintf(dirs[n++], "%s/%s", parent, d->d_name);
+	    }
+	}
+	if (dp != NULL)
+	    closedir(dp);
+    } else if (dirExists(templtDir)) {
+	BUFGROW(dirs, n + 1, ERMA_NO_MEMORY_DIRSCAN);
+	dirs[n++] = strsave(templtDir);
+    }
+    *pDirsSize = dirsSize;
+    *pN = n;
+    return dirs;
+}
+
+
+/* Get a list of unprocessed files - those that match the pattern (template) in
+ * infilePattern and aren't yet in the set of processed files 'processed' (which
+ * may be NULL, meaning none are). Directories the directory-scan state file at
+ * statePath says have nothing new are skipped; the file is then brought up to
+ * date. If statePath is "", every directory is read and no state is kept.
+ *
+ * Returns a new NULL-terminated array of pathnames with malloc'ed strings
+ * having the names that aren't yet processed, sorted by file name (and so by
+ * time), or NULL if no directory matches the infilePattern.
+ */
+char **getNewFiles(STRSET *processed, char *dir, char *infilePattern,
+		   char *statePath)
+{
+    char templt0[256], templtDir[256];
+
+    /* Make a complete template with both dir template/name and file template,
+     * and split it into the two. */
+    snprintf(templt0, sizeof(templt0), "%s/%s", dir, infilePattern);
+    pathDir(templtDir, templt0);
+    char *tfn = pathFile(templt0);	//template file name
+
+    char **dirs = NULL;
+    size_t dirsSize = 0;
+    int32 nDirs = 0;
+    dirs = listDirs(templtDir, dirs, &dirsSize, &nDirs);
+    if (nDirs == 0)
+	return NULL;
+
+    int32 nOld;
+    DIRSTATE *old = readState(statePath, infilePattern, &nOld);
+    DIRSTATE *cur = NULL;		//the new state
+    size_t curSize = 0;
+    int32 nCur = 0, nSkipped = 0, nSkippedFiles = 0;
+    char **unprocessed = NULL;
+    size_t unprocessedSize = 0;		//for bufgrow
+    int32 nFiles = 0;
+    time_t now = time(NULL);
+
+    /* Find the newest directory, the last by name (for WISPR's, by date). */
+    int32 newest = 0;
+    for (int32 di = 1; di < nDirs; di++)
+	if (cmpByFileName(&dirs[di], &dirs[newest]) > 0)
+	    newest = di;
+
+    for (int32 di = 0; di < nDirs; di++) {
+	struct stat st;
+	if (stat(dirs[di], &st) != 0)
+	    continue;
+	DIRSTATE key = { dirs[di] };
+	DIRSTATE *known = (nOld == 0) ? NULL :
+	    bsearch(&key, old, nOld, sizeof(old[0]), cmpDirState);
+	if (known != NULL && di != newest && known->mtimeS == st.st_mtim.tv_sec
+	    && known->mtimeNs == st.st_mtim.tv_nsec
+	    && known->size == st.st_size) {
+	    /* Nothing's changed here since it was last read. */
+	    BUFGROW(cur, nCur + 1, ERMA_NO_MEMORY_DIRSCAN);
+	    cur[nCur] = *known;
+	    cur[nCur++].path = strsave(known->path);
+	    nSkipped++;
+	    nSkippedFiles += known->nFiles;
+	    continue;
+	}
+
+	/* Read the directory. Append each matching file to 'unprocessed' if
+	 * it's not already in the processed set. */
+	DIR *dp = opendir(dirs[di]);
+	if (dp == NULL)
+	    continue;
+	int32 nHere = 0, nNewHere = 0;
+	struct dirent *d;
+	while ((d = readdir(dp)) != NULL) {
+	    if (fnmatch(tfn, d->d_name, FNM_PERIOD) != 0
+		|| !entryIs(d, dirs[di], S_IFREG))
+		continue;
+	    nHere++;
+	    if (processed != NULL && strSetHas(processed, d->d_name))
+		continue;
+	    BUFGROW(unprocessed, nFiles + 1, ERMA_NO_MEMORY_UNPROCESSED);
+	    unprocessed[nFiles] = malloc(strlen(dirs[di]) +
+					 strlen(d->d_name) + 2);
+	    if (unprocessed[nFiles] == NULL)
+		exit(ERMA_NO_MEMORY_UNPROCESSED);
+	    sprintf(unprocessed[nFiles++], "%s/%s", dirs[di], d->d_name);
+	    nNewHere++;
+	}
+	closedir(dp);
+
+	/* Remember it if it's all done, has settled, and isn't the newest. */
+	if (nNewHere == 0 && di != newest
+	    && now - st.st_mtim.tv_sec >= DIRSCAN_SETTLE_S) {
+	    BUFGROW(cur, nCur + 1, ERMA_NO_MEMORY_DIRSCAN);
+	    cur[nCur].path = strsave(dirs[di]);
+	    cur[nCur].mtimeS = st.st_mtim.tv_sec;
+	    cur[nCur].mtimeNs = st.st_mtim.tv_nsec;
+	    cur[nCur].size = st.st_size;
+	    cur[nCur++].nFiles = nHere;
+	}
+    }
+    BUFGROW(unprocessed, nFiles + 1, ERMA_NO_MEMORY_UNPROCESSED);
+    unprocessed[nFiles] = NULL;
+    qsort(unprocessed, nFiles, sizeof(unprocessed[0]), cmpByFileName);
+
+    if (statePath[0] != '\0') {
+	if (nCur > 0)
+	    qsort(cur, nCur, sizeof(cur[0]), cmpDirState);
+	writeState(statePath, infilePattern, cur, nCur);
+	printf("getNewFiles: %d of %d directories unchanged (%d files), "
+	       "not read\n", nSkipped, nDirs, nSkippedFiles);
+    }
+    for (int32 i = 0; i < nOld; i++)
+	free(old[i].path);
+    free(old);
+    for (int32 i = 0; i < nCur; i++)
+	free(cur[i].path);
+    free(cur);
+    for (int32 i = 0; i < nDirs; i++)
+	free(dirs[i]);
+    free(dirs);
+
+    printf("getNewFiles: %d new files to process\n", nFiles);
+    return unprocessed;
+}
@@ -0,0 +1,18 @@
+#ifndef _DIRSCAN_H_
+#define _DIRSCAN_H_
+
+/* A directory that getNewFiles has found nothing new in, as remembered in the
+ * directory-scan state file (see dirScan.c).
+ */
+typedef struct {
+    char *path;		//the directory
+    int64 mtimeS;	//its modification time, s since the Epoch...
+    int32 mtimeNs;	//...plus this many ns
+    int64 size;		//its size, which on FAT grows by whole clusters
+    int32 nFiles;	//# of input files it had, all of them processed
+} DIRSTATE;
+
+char **getNewFiles(STRSET *processed, char *dir, char *infilePattern,
+		   char *statePath);
+
+#endif	/* _DIRSCAN_H_ */
@@ -0,0 +1,225 @@
+
+#include "erma.h"
+
+/* Binary encounter reports: making them as saveEncounters writes the CSV, and
+ * turning them back into the CSV on shore. See encReport.h for the format.
+ */
+
+
+void encRepInit(ENCREPORT *er)
+{
+    er->buf = NULL;
+    er->bufSize = 0;
+    er->n = 0;
+    er->prevT = 0;
+    er->prevMs = 0;
+    er->nClick = 0;
+}
+
+
+static void putByte(ENCREPORT *er, uint8_t b)
+{
+    BUFGROW(er->buf, er->n + 1, ERMA_NO_MEMORY_ENCOUNTERS);
+    er->buf[er->n++] = b;
+}
+
+
+static void putUVarint(ENCREPORT *er, uint64 v)
+{
+    while (v >= 0x80) {
+	putByte(er, (v & 0x7f) | 0x80);
+	v >>= 7;
+    }
+    putByte(er, v);
+}
+
+
+static void putSVarint(ENCREPORT *er, int64 v)
+{
+    putUVarint(er, ((uint64)v << 1) ^ (uint64)(v >> 63));	//zigzag
+}
+
+
+/* $analyzed: processing covered t0 to t1, seconds since the Epoch, or 0 and 0
+ * if there's nothing. */
+void encRepAnalyzed(ENCREPORT *er, int64 t0, int64 t1)
+{
+    putByte(er, 'a');
+    putUVarint(er, t0);
+    putUVarint(er, t1 - t0);
+    er->prevT = t0;
+}
+
+
+/* $enc: an encounter from t0 to t1, seconds since the Epoch, with nClicks
+ * clicks, nSaved of which come next with encRepClick. */
+void encRepEnc(ENCREPORT *er, int64 t0, int64 t1, int32 nClicks, int32 nSaved)
+{
+    putByte(er, 'e');
+    putSVarint(er, t0 - er->prevT);
+    putUVarint(er, t1 - t0);
+    putUVarint(er, MAX(0, nClicks));
+    putUVarint(er, MAX(0, nSaved));
+    er->prevT = t0;
+    er->nClick = 0;
+}
+
+
+/* A saved click time, as text with 3 decimal places, the way it's written in
+ * the CSV (without the comma). */
+void encRepClick(ENCREPORT *er, char *text)
+{
+    int neg = (text[0] == '-');
+    int64 ms = 0;
+    for (char *p = text + neg; *p != '\0'; p++)
+	if (*p != '.')
+	    ms = ms * 10 + (*p - '0');
+    ms = neg ? -ms : ms;
+    if (er->nClick++ == 0)
+	putSVarint(er, ms);
+    else
+	putSVarint(er, ms - er->prevMs);
+    er->prevMs = ms;
+}
+
+
+void encRepProcessTime(ENCREPORT *er, int64 sec)
+{
+    putByte(er, 'p');
+    putSVarint(er, sec);
+}
+
+
+/* Append the report to the file path, starting it with ENCREP_MAGIC if it's
+ * new. Return 1 if it worked. */
+int encRepWrite(ENCREPORT *er, char *path)
+{
+    FILE *fp = fopen(path, "a");
+    if (fp == NULL)
+	return 0;
+    int bad = 0;
+    if (ftell(fp) == 0)
+	bad |= (fwrite(ENCREP_MAGIC, 1, 4, fp) != 4);
+    bad |= (fwrite(er->buf, 1, er->n, fp) != er->n);
+    bad |= (fclose(fp) != 0);
+    return !bad;
+}
+
+
+static int getUVarint(FILE *in, uint64 *pV)
+{
+    uint64 v = 0;
+    int c;
+    for (int shift = 0; shift < 64; shift += 7) {
+	if ((c = getc(in)) == EOF)
+	    return 0;
+	v |= (uint64)(c & 0x7f) << shift;
+	if (!(c & 0x80)) {
+	    *pV = v;
+	    return 1;
+	}
+    }
+    return 0;
+}
+
+
+static int getSVarint(FILE *in, int64 *pV)
+{
+    uint64 u;
+    if (!getUVarint(in, &u))
+	return 0;
+    *pV = (int64)(u >> 1) ^ -(int64)(u & 1);
+    return 1;
+}
+
+
+/* Write the time ms (milliseconds) to out as ",%.3lf" would. */
+static void putMs(FILE *out, int64 ms)
+{
+    fprintf(out, ",%s%lld.%03lld", ms < 0 ? "-" : "",
+	    (long long)(llabs(ms) / 1000), (long long)(llabs(ms) % 1000));
+}
+
+
+/* Turn the binary report in into the CSV that saveEncounters writes, on out.
+ * Return 1 if it worked, or 0 if in isn't a good report.
+ */
+int encRepDecode(FILE *in, FILE *out)
+{
+    char magic[4], buf0[20], buf1[20];
+    int64 prevT = 0, dt, ms, d;
+    uint64 t0, len, nClicks, nSaved;
+    int c;
+
+    while (fread(magic, 1, 4, in) == 4) {	//magic again if appended to
+	if (memcmp(magic, ENCREP_MAGIC, 4))
+	    return 0;
+	while ((c = getc(in)) != EOF && c != ENCREP_MAGIC[0]) {
+	    switch (c) {
+	    case 'a':
+		if (!getUVarint(in, &t0) || !getUVarint(in, &len))
+		    return 0;
+		fprintf(out, "$analyzed,%s,%s\n",
+			t0 == 0 ? "0" : timeStrE(buf0, t0),
+			t0 == 0 ? "0" : timeStrE(buf1, t0 + len));
+		prevT = t0;
+		break;
+	    case 'e':
+		if (!getSVarint(in, &dt) || !getUVarint(in, &len) ||
+		    !getUVarint(in, &nClicks) || !getUVarint(in, &nSaved))
+		    return 0;
+		prevT += dt;
+		fprintf(out, "$enc,%s,%s,%d", timeStrE(buf0, prevT),
+			timeStrE(buf1, prevT + len), (int)nClicks);
+		ms = 0;
+		for (uint64 i = 0; i < nSaved; i++) {
+		    if (!getSVarint(in, &d))
+			return 0;
+		    ms = (i == 0) ? d : ms + d;
+		    putMs(out, ms);
+		}
+		fprintf(out, "\n");
+		break;
+	    case 'p':
+		if (!getSVarint(in, &d))
+		    return 0;
+		fprintf(out, "$processtimesec,%lld\n", (long long)d);
+		break;
+	    default:
+		return 0;
+	    }
+	}
+	if (c == EOF)
+	    break;
+	ungetc(c, in);
+    }
+    return 1;
+}
+
+
+/* "ErmaMain -decodeenc report [out.csv]": turn a binary encounter report back
+ * into the CSV, on stdout if out.csv isn't given. args has the nArgs arguments
+ * after "-decodeenc".
+ */
+int encRepMain(int nArgs, char **args)
+{
+    if (nArgs < 1 || nArgs > 2) {
+	fprintf(stderr, "Usage: ErmaMain -decodeenc report [out.csv]\n");
+	return ERMA_ENCREP_BAD_FILE;
+    }
+    FILE *in = fopen(args[0], "rb");
+    FILE *out = (nArgs > 1) ? fopen(args[1], "w") : stdout;
+    if (in == NULL || out == NULL) {
+	fprintf(stderr, "Can't open %s\n", in == NULL ? args[0] : args[1]);
+	return ERMA_ENCREP_BAD_FILE;
+    }
+    int ok = encRepDecode(in, out);
+    fclose(in);
+    if (out != stdout)
+	fclose(out);
+    if (!ok) {
+	fprintf(stderr, "%s isn't a good encounter report\n", args[0]);
+	return ERMA_ENCREP_BAD_FILE;
+    }
+    return 0;
+}
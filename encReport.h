@@ -0,0 +1,42 @@
+#ifndef _ENCREPORT_H_
+#define _ENCREPORT_H_
+
+/* A binary encounter report holds the same things as the encounter_dets CSV
+ * that saveEncounters writes, in far fewer bytes, for when the uplink is what
+ * costs. It starts with ENCREP_MAGIC and then has one record per CSV line,
+ * each a type byte and then varints (LEB128; signed ones are zigzagged):
+ *
+ *  'a'	$analyzed:	start s, end - start s; start 0 means "0,0"
+ *  'e'	$enc:		start - previous start s (signed; the previous start
+ *			is the $analyzed one for the first), end - start s,
+ *			number of clicks, number saved, then the saved click
+ *			times in ms from the start: the first one, then each
+ *			minus the one before (signed)
+ *  'p'	$processtimesec: s (signed)
+ *
+ * Times are in seconds since the Epoch, as the CSV's yymmdd-HHMMSS strings are.
+ * The click times are taken from the CSV text itself, so that
+ * "ErmaMain -decodeenc" gives back exactly the same CSV.
+ */
+#define ENCREP_MAGIC	"ERB\001"	//"ERB" and version 1
+
+typedef struct {
+    uint8_t *buf;	//the report so far
+    size_t bufSize;	//for bufgrow
+    size_t n;		//number of bytes in buf
+    int64 prevT;	//start time of the last $analyzed or $enc, s
+    int64 prevMs;	//last click time written, ms
+    int32 nClick;	//number of clicks written in this $enc
+} ENCREPORT;
+
+void encRepInit(ENCREPORT *er);
+void encRepAnalyzed(ENCREPORT *er, int64 t0, int64 t1);
+void encRepEnc(ENCREPORT *er, int64 t0, int64 t1, int32 nClicks,
+	       int32 nSaved);
+void encRepClick(ENCREPORT *er, char *text);
+void encRepProcessTime(ENCREPORT *er, int64 sec);
+int encRepWrite(ENCREPORT *er, char *path);
+int encRepDecode(FILE *in, FILE *out);
+int encRepMain(int nArgs, char **args);
+
+#endif	/* _ENCREPORT_H_ */
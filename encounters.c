@@ -2,8 +2,15 @@
 #include "erma.h"
 
 /* Defined below */
-static void addEncounter(int32 encStart, int32 encEnd,
-			 int32 minBlock, float blocksPerDay, ENCOUNTERS *enc);
+static void countHits(ALLCLICKS *allC, int32 start, int64 minBlock,
+		      int32 nBlocks, double blocksPerDay, double blockLenD,
+		      int32 *nHits);
+static int blockHas(int32 i, int64 minBlock, double blocksPerDay,
+		    double blockLenD, double tD);
+static void stepBlock(ENCSTATE *es, ERMAPARAMS *ep, int32 nClicks,
+		      double blocksPerDay, ENCOUNTERS *enc);
+static void addEncounter(int64 encStartBlk, int64 encEndBlk,
+			 double blocksPerDay, ENCOUNTERS *enc);
 
 
 void initENCOUNTERS(ENCOUNTERS *enc)
@@ -14,6 +21,34 @@ void initENCOUNTERS(ENCOUNTERS *enc)
 }
 
 
+void initENCSTATE(ENCSTATE *es)
+{
+    es->isHit = NULL;
+    es->isHitSize = 0;
+    es->curBlock = -1;
+    es->nDone = 0;
+}
+
+
+/* Set es up for a fresh start, with no blocks seen yet, for the encounter
+ * params in ep.
+ */
+void resetENCSTATE(ENCSTATE *es, ERMAPARAMS *ep)
+{
+    es->blockLenS = ep->blockLenS;
+    es->nWin = MAX(1, (int32)ep->consecBlocks);
+    BUFGROW(es->isHit, es->nWin + 1, ERMA_NO_MEMORY_ENCCOUNT);
+    memset(es->isHit, 0, (es->nWin + 1) * sizeof(es->isHit[0]));
+    es->curBlock = -1;
+    es->curClicks = 0;
+    es->nInConsec = 0;
+    es->inEnc = 0;
+    es->encStartBlk = -1;
+    es->repStartBlk = es->repEndBlk = -1;
+    es->nDone = 0;
+}
+
+
 /* Find the whale 'encounters' from a set of detected clicks. For example, we
  * can say an encounter is when there are 15 or more clicks in a minute, and
  * this happens for at least 5 of the minutes in a 10-minute span.
@@ -24,109 +59,285 @@ void initENCOUNTERS(ENCOUNTERS *enc)
  * considered a 'hit'. When there is a set of 'consecBlocks' consecutive blocks
  * (e.g., 10) with at least 'hitsPerEnc' (e.g., 5) of them being hits, then
  * we've found an encounter.
+ *
+ * This works incrementally: es has where things stood after the clicks seen
+ * before, possibly in an earlier run (see encStateRead), and only the clicks
+ * in allC after the first es->nDone are new. The blocks those clicks are in
+ * are stepped through, carrying on from es, and the encounters that end are
+ * added to enc. The newest block could still get more clicks, so it isn't
+ * stepped through yet, and an encounter still going at the end isn't added
+ * to enc; see finishEncounters. Clicks that are earlier than the blocks
+ * already stepped through can't be counted any more and are skipped.
  */
-
-void findEncounters(ALLCLICKS *allC, ERMAPARAMS *ep, ENCOUNTERS *enc)
+void findEncounters(ALLCLICKS *allC, ERMAPARAMS *ep, ENCSTATE *es,
+		    ENCOUNTERS *enc)
 {
     int32 secPerDay = 24*60*60;
-    float blocksPerDay = (float)secPerDay / ep->blockLenS;
-    float blockLenD = ep->blockLenS / secPerDay;	//block length in days
+    //These are double, as block start times in days since the Epoch need more
+    //bits than a float has: in float they'd be rounded to ~3 minutes.
+    double blocksPerDay = (double)secPerDay / ep->blockLenS;
+    double blockLenD = (double)ep->blockLenS / secPerDay; //block length, days
 
-    if (allC->n == 0)					//special case
+    if (allC->n <= es->nDone)				//special case
 	return;
-    
-    /* Find first and last times of clicks */
-    double minTimeD = DBL_MAX, maxTimeD = -DBL_MAX;
-    for (int32 i = 0; i < allC->n; i++) {
-	if (allC->timeD[i] < minTimeD) minTimeD = allC->timeD[i];
-	if (allC->timeD[i] > maxTimeD) maxTimeD = allC->timeD[i];
+    int32 start = es->nDone;		//first new click
+    es->nDone = allC->n;
+
+    /* Find first and last times of new clicks */
+    double tD, minTimeD = DBL_MAX, maxTimeD = -DBL_MAX;
+    CLICKITER it;
+    clickIterStart(&it, allC, start);
+    while (clickIterNext(&it, &tD)) {
+	if (tD < minTimeD) minTimeD = tD;
+	if (tD > maxTimeD) maxTimeD = tD;
     }
-    int32 minBlock = floor(minTimeD * blocksPerDay);
-    int32 maxBlock =  ceil(maxTimeD * blocksPerDay);
+    int64 minBlock = floor(minTimeD * blocksPerDay);
+    int64 maxBlock = floor(maxTimeD * blocksPerDay) + 1;
     int32 nBlocks = maxBlock - minBlock;
 
-    static int32 *nHits = NULL, *isHit = NULL;
-    static size_t nHitsSize = 0, isHitSize = 0;
-    BUFGROW(isHit, nBlocks, ERMA_NO_MEMORY_NHITS);
+    static int32 *nHits = NULL;
+    static size_t nHitsSize = 0;
     BUFGROW(nHits, nBlocks, ERMA_NO_MEMORY_NHITS);
+    countHits(allC, start, minBlock, nBlocks, blocksPerDay, blockLenD, nHits);
 
-    for (int32 i = 0; i < nBlocks; i++) {
-	/* Find start and end of block i, in days */
-	double blockT0_D = (minBlock+i) / blocksPerDay;//block start time, days
-	double blockT1_D = blockT0_D + blockLenD;      //block  end  time, days
-	/* Count how many hits are in block i */
-	int32 nn = 0;
-	for (int32 j = 0; j < allC->n; j++)
-	    nn += (allC->timeD[j] >= blockT0_D && allC->timeD[j] < blockT1_D);
-	nHits[i] = nn;
-	isHit[i] = (nn >= ep->clicksPerBlock);
+    /* Step through the blocks from the one left open last time (or the first
+     * new one) up to the newest, which is left open. */
+    if (es->curBlock < 0) {
+	es->curBlock = minBlock;
+	es->curClicks = 0;
+    }
+    int32 nLate = 0;
+    for (int64 i = minBlock; i < MIN(es->curBlock, maxBlock); i++)
+	nLate += nHits[i - minBlock];
+    int32 n = es->curClicks;
+    while (1) {
+	int64 b = es->curBlock;
+	n += (b >= minBlock && b < maxBlock) ? nHits[b - minBlock] : 0;
+	if (b >= maxBlock - 1)
+	    break;
+	stepBlock(es, ep, n, blocksPerDay, enc);		//curBlock++
+	n = 0;
+	/* Once the window is empty and there's no encounter, there's nothing
+	 * to do until the next click, which could be hours or days on. */
+	if (es->curBlock < minBlock && es->nInConsec == 0 && !es->inEnc) {
+	    memset(es->isHit, 0, (es->nWin + 1) * sizeof(es->isHit[0]));
+	    es->curBlock = minBlock;
+	}
     }
+    es->curClicks = n;
+    if (nLate > 0)
+	printf("findEncounters: %d click(s) too early to count\n", nLate);
+}
 
-    static int32 *count = NULL;
-    static size_t countSize = 0;
-    BUFGROW(count, nBlocks, ERMA_NO_MEMORY_ENCCOUNT);
 
-    for (int32 i = 0; i < nBlocks; i++)
-	count[i] = 0;
-    
-    int32 nInConsec = 0;	//# of hits in the span (p0,p1]  (!)
-    int inEnc = 0;		//currently in an encounter?
-    int32 encStartBlk;		//start block # of encounter
-    for (int32 p0 = -ep->consecBlocks, p1 = 0; p0 < nBlocks+1; p0++, p1++) {
-	nInConsec -= (p0 >= 0      ? isHit[p0] : 0);
-	nInConsec += (p1 < nBlocks ? isHit[p1] : 0);
-	if (p1 < nBlocks)
-	    count[p1] = nInConsec;
-	
-	/* If we're in an encounter, continue in it as long as count stays high
-	 * enough; as soon as count drops below, find the last time that count
-	 * was high enough and end the encounter there, and record it.
-	 */
-	int encHere = (nInConsec >= ep->hitsPerEnc);
-	if (inEnc && encHere)	 {
-	    /* Encounter continues; don't need to do anything. */
-	} else if (inEnc && ~encHere) {
-	    /* Finish encounter. It ends at last hit in the span [p0,p1). */
-	    int32 encEndBlk = MAX(0, p0);	//set it in case j loop finishes
-	    for (int32 j = MIN(nBlocks,p1) - 1; j >= MAX(0, p0); j--) {
-		if (isHit[j]) {
-		    encEndBlk = j;
-		    break;
-		}
+/* Finish off the encounters for this run: if the newest block or an encounter
+ * is still open in es, add to enc the encounter that would result if no more
+ * clicks came. es itself isn't changed, except to note what was added, so that
+ * it isn't added again later if it does end up that way. If more clicks come,
+ * though, the encounter may go on, and then it's added again, with its start
+ * as before and a later end.
+ */
+void finishEncounters(ENCSTATE *es, ERMAPARAMS *ep, ENCOUNTERS *enc)
+{
+    static int32 *isHit = NULL;
+    static size_t isHitSize = 0;
+    double blocksPerDay = 24*60*60 / (double)ep->blockLenS;
+
+    if (es->curBlock >= 0) {
+	/* Work on a copy of es, stepping through the open block and then empty
+	 * ones until the window is empty. */
+	ENCSTATE tmp = *es;
+	BUFGROW(isHit, es->nWin + 1, ERMA_NO_MEMORY_ENCCOUNT);
+	memcpy(isHit, es->isHit, (es->nWin + 1) * sizeof(isHit[0]));
+	tmp.isHit = isHit;
+	int32 n0 = enc->n;
+	stepBlock(&tmp, ep, tmp.curClicks, blocksPerDay, enc);
+	for (int32 i = 0; i <= tmp.nWin && tmp.inEnc; i++)
+	    stepBlock(&tmp, ep, 0, blocksPerDay, enc);
+	if (tmp.inEnc) {
+	    //This can happen only if hitsPerEnc <= 0.
+	    addEncounter(tmp.encStartBlk, es->curBlock, blocksPerDay, enc);
+	    tmp.repStartBlk = tmp.encStartBlk;
+	    tmp.repEndBlk = es->curBlock;
+	}
+	if (enc->n > n0) {
+	    es->repStartBlk = tmp.repStartBlk;
+	    es->repEndBlk = tmp.repEndBlk;
+	}
+    }
+    printf("findEncounters: found %d encounters so far in this run\n", enc->n);
+}
+
+
+/* Take in block es->curBlock, which has nClicks clicks, and move on to the
+ * next one. This is a step of the sliding window: the window is the span
+ * (p0,p1] of consecBlocks blocks ending at block p1, and es->nInConsec is the
+ * number of hits in it. If an encounter ends, it's added to enc.
+ */
+static void stepBlock(ENCSTATE *es, ERMAPARAMS *ep, int32 nClicks,
+		      double blocksPerDay, ENCOUNTERS *enc)
+{
+    int32 nRing = es->nWin + 1;		//es->isHit is a ring this long...
+#define HIT(blk)  (es->isHit[(blk) % nRing])	//...indexed by block #
+    int64 p1 = es->curBlock, p0 = p1 - es->nWin;
+
+    es->nInConsec -= HIT(p0);
+    HIT(p1) = (nClicks >= ep->clicksPerBlock);
+    es->nInConsec += HIT(p1);
+
+    /* If we're in an encounter, continue in it as long as count stays high
+     * enough; as soon as count drops below, find the last time that count
+     * was high enough and end the encounter there, and record it.
+     */
+    int encHere = (es->nInConsec >= ep->hitsPerEnc);
+    if (es->inEnc && !encHere) {
+	/* Finish encounter. It ends at last hit in the span [p0,p1). */
+	int64 encEndBlk = p0;		//set it in case j loop finishes
+	for (int64 j = p1 - 1; j >= p0; j--) {
+	    if (HIT(j)) {
+		encEndBlk = j;
+		break;
 	    }
-	    addEncounter(encStartBlk, encEndBlk, minBlock, blocksPerDay, enc);
-/*	    BUFGROW(enc->tSpanD, enc->n + 1, ERMA_NO_MEMORY_ENCOUNTERS);*/
-/*	    enc->tSpanD[enc->n][0] = (encStartBlk + minBlock) / blocksPerDay;*/
-/*	    enc->tSpanD[enc->n][1] = (encEndBlk   + minBlock) / blocksPerDay;*/
-
-	} else if (~inEnc && encHere) {
-	    /* Start an encounter at the first hit in the current p0:p1 span. */
-	    for (int32 j = MAX(0,p0); j < MIN(nBlocks,p1+1); j++) {
-		if (isHit[j]) {
-		    encStartBlk = j;
-		    break;
-		}
+	}
+	//Skip it if it's already been added, as it was, by finishEncounters.
+	if (es->encStartBlk != es->repStartBlk || encEndBlk != es->repEndBlk)
+	    addEncounter(es->encStartBlk, encEndBlk, blocksPerDay, enc);
+	es->repStartBlk = es->encStartBlk;
+	es->repEndBlk = encEndBlk;
+    } else if (!es->inEnc && encHere) {
+	/* Start an encounter at the first hit in the current p0:p1 span. */
+	for (int64 j = p0; j <= p1; j++) {
+	    if (HIT(j)) {
+		es->encStartBlk = j;
+		break;
 	    }
-	} else if (~inEnc && ~encHere) {
-	    /* Non-encounter continues; don't need to do anything. */
 	}
-	
-	inEnc = encHere;
-    }	//for (p0,p1...)
-    if (inEnc) {
-	//The set of files ended in the middle of an encounter. Add it.
-	addEncounter(encStartBlk, nBlocks-1, minBlock, blocksPerDay, enc);
     }
-    printf("findEncounters: found %d encounters so far in this run\n", enc->n);
+    es->inEnc = encHere;
+    es->curBlock++;
+#undef HIT
+}
+
+
+/* Read the encounter state saved by encStateWrite at the end of the last run
+ * into es. If there's no such file, or it was saved with different block
+ * params than the ones in ep, es starts afresh. The file is a few lines of
+ * text:
+ *
+ *	ermaEncState 1
+ *	<blockLenS> <nWin>
+ *	<curBlock> <curClicks> <nInConsec> <inEnc> <encStartBlk> <repStartBlk>
+ *	    <repEndBlk>
+ *	<hit flags (0 or 1) of blocks curBlock-nWin-1 .. curBlock-1>
+ */
+void encStateRead(ENCSTATE *es, ERMAPARAMS *ep, char *path)
+{
+    resetENCSTATE(es, ep);
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL)
+	return;
+
+    int version, inEnc, nWin = 0, ok;
+    float blockLenS;
+    long long curBlock = 0, encStart, repStart, repEnd;
+    int32 curClicks, nInConsec;
+    ok = (fscanf(fp, "ermaEncState %d %f %d", &version, &blockLenS, &nWin) == 3
+	  && version == 1 && blockLenS == es->blockLenS && nWin == es->nWin &&
+	  fscanf(fp, "%lld %d %d %d %lld %lld %lld", &curBlock, &curClicks,
+		 &nInConsec, &inEnc, &encStart, &repStart, &repEnd) == 7);
+    if (ok)
+	for (int64 b = curBlock - nWin - 1; ok && b < curBlock; b++)
+	    ok = (b < 0) || fscanf(fp, "%d", &es->isHit[b % (nWin+1)]) == 1;
+    fclose(fp);
+    if (!ok) {
+	printf("encStateRead: starting afresh, not using %s\n", path);
+	resetENCSTATE(es, ep);
+	return;
+    }
+    es->curBlock = curBlock;
+    es->curClicks = curClicks;
+    es->nInConsec = nInConsec;
+    es->inEnc = inEnc;
+    es->encStartBlk = encStart;
+    es->repStartBlk = repStart;
+    es->repEndBlk = repEnd;
+}
+
+
+/* Save es in path for the next run. As with the noise percentiles, it's
+ * written to a temporary file first and then renamed, so a power cut leaves
+ * either the old state or the new one.
+ */
+void encStateWrite(ENCSTATE *es, char *path)
+{
+    char tmpPath[strlen(path) + 5];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+
+    FILE *fp = fopen(tmpPath, "w");
+    int bad = (fp == NULL);
+    if (!bad) {
+	//%.9g so blockLenS reads back as the same float, to compare with ==
+	fprintf(fp, "ermaEncState 1\n%.9g %d\n", es->blockLenS, es->nWin);
+	fprintf(fp, "%lld %d %d %d %lld %lld %lld\n", (long long)es->curBlock,
+		es->curClicks, es->nInConsec, es->inEnc,
+		(long long)es->encStartBlk, (long long)es->repStartBlk,
+		(long long)es->repEndBlk);
+	for (int64 b = es->curBlock - es->nWin - 1; b < es->curBlock; b++)
+	    if (b >= 0)
+		fprintf(fp, "%d ", es->isHit[b % (es->nWin + 1)]);
+	fprintf(fp, "\n");
+	bad = (fflush(fp) != 0 || fsync(fileno(fp)) != 0);
+	bad |= (fclose(fp) != 0);
+    }
+    if (bad || rename(tmpPath, path))
+	fprintf(stderr, "Can't save encounter state in %s\n", path);
 }
 
 
-static void addEncounter(int32 encStartBlk, int32 encEndBlk,
-			 int32 minBlock, float blocksPerDay, ENCOUNTERS *enc)
+/* Count how many of the clicks in allC, from click number start on, are in
+ * each of nBlocks blocks starting with block number minBlock, putting the
+ * counts in nHits. Rather than checking every click against every block, this
+ * puts each click straight into its block. The block start and end times are
+ * rounded, so a click right at a block edge is checked against the neighboring
+ * blocks too, with the test in blockHas; this gives exactly the counts that
+ * checking all pairs does.
+ */
+static void countHits(ALLCLICKS *allC, int32 start, int64 minBlock,
+		      int32 nBlocks, double blocksPerDay, double blockLenD,
+		      int32 *nHits)
+{
+    CLICKITER it;
+    double t;
+
+    for (int32 i = 0; i < nBlocks; i++)
+	nHits[i] = 0;
+    clickIterStart(&it, allC, start);
+    while (clickIterNext(&it, &t)) {
+	int32 b = (int64)floor(t * blocksPerDay) - minBlock;
+	for (int32 i = MAX(0, b-1); i <= MIN(nBlocks-1, b+1); i++)
+	    nHits[i] += blockHas(i, minBlock, blocksPerDay, blockLenD, t);
+    }
+}
+
+
+/* Return 1 if time tD, in days, falls in block i (counting from block number
+ * minBlock) of length blockLenD.
+ */
+static int blockHas(int32 i, int64 minBlock, double blocksPerDay,
+		    double blockLenD, double tD)
+{
+    double blockT0_D = (minBlock+i) / blocksPerDay;	//block start time, days
+    double blockT1_D = blockT0_D + blockLenD;		//block  end  time, days
+    return (tD >= blockT0_D && tD < blockT1_D);
+}
+
+
+static void addEncounter(int64 encStartBlk, int64 encEndBlk,
+			 double blocksPerDay, ENCOUNTERS *enc)
 {
     BUFGROW(enc->tSpanD, enc->n + 1, ERMA_NO_MEMORY_ENCOUNTERS);
-    enc->tSpanD[enc->n].t0 = (encStartBlk + minBlock) / (double)blocksPerDay;
-    enc->tSpanD[enc->n].t1 = (encEndBlk   + minBlock) / (double)blocksPerDay;
+    enc->tSpanD[enc->n].t0 = encStartBlk / blocksPerDay;
+    enc->tSpanD[enc->n].t1 = encEndBlk   / blocksPerDay;
     enc->n++;
 }
 
@@ -190,19 +401,24 @@ end
 /* Save some detections from each encounter in goodDetsPath. The number of
  * detections is proportional to the duration of the encounter, relative to the
  * total duration of all encounters.  Also append the name of the output file to
- * encFileListPath (wispr_dtx_list.txt).
+ * encFileListPath (wispr_dtx_list.txt). If binary is 1, the same report is
+ * also made in the compact binary form (see encReport.h), in a file named like
+ * piEncDetsPath but ending in .bin, and that's the one put in encFileListPath.
  *
  * Need to also save an average spectrum.
  */
 void saveEncounters(ENCOUNTERS *enc, ALLCLICKS *allC, char *piEncDetsPath,
 		    char *wisprEncDetsPath, double tMinE, double tMaxE,
 		    char *encFileListPath, int32 clicksToSave,
-		    time_t startTime)
+		    time_t startTime, int binary)
 {
     FILE *fp = fopen(piEncDetsPath, "a");
     const double secPerDay = 24 * 60 * 60;
+    ENCREPORT er;
+    encRepInit(&er);
 
     printf("saveEncounters: %d encounter(s)\n", enc->n);
+    sortALLCLICKS(allC);		//for allClicksFirstAfter
 
     if (fp != NULL) {
 	/* Add up the duration of all encounters. */
@@ -215,6 +431,8 @@ void saveEncounters(ENCOUNTERS *enc, ALLCLICKS *allC, char *piEncDetsPath,
 	fprintf(fp, "$analyzed,%s,%s\n",
 		(tMaxE < 0) ? "0" : timeStrE(buf0, (time_t)floor(tMinE)),
 		(tMaxE < 0) ? "0" : timeStrE(buf1, (time_t) ceil(tMaxE)));
+	encRepAnalyzed(&er, (tMaxE < 0) ? 0 : (int64)floor(tMinE),
+		       (tMaxE < 0) ? 0 : (int64) ceil(tMaxE));
 
 	/* Write out [some of] the clicks in this encounter. */
 	for (int32 i = 0; i < enc->n; i++) {
@@ -227,13 +445,10 @@ void saveEncounters(ENCOUNTERS *enc, ALLCLICKS *allC, char *piEncDetsPath,
 	    fprintf(fp, "$enc,%s,%s", timeStrD(buf0, t0D), timeStrD(buf1, t1D));
 
 	    //Find indices of first (i0) & last (i1) clicks in this encounter.
-	    int32 i0 = -1, i1 = -1;
-	    for (int32 j = 0; j < allC->n; j++) {
-		if (t0D <= allC->timeD[j] && allC->timeD[j] <= t1D) {
-		    if (i0 == -1) i0 = j;
-		    i1 = j;
-		}
-	    }
+	    int32 i0 = allClicksFirstAfter(allC, t0D, 1);
+	    int32 i1 = allClicksFirstAfter(allC, t1D, 0) - 1;
+	    if (i1 < i0)
+		i0 = i1 = -1;			//no clicks in it
 	    fprintf(fp, ",%d", i1 - i0);	//write number of clicks
 
 	    //Save the clicks in the MIDDLE of the encounter, since those might
@@ -241,19 +456,199 @@ void saveEncounters(ENCOUNTERS *enc, ALLCLICKS *allC, char *piEncDetsPath,
 	    int32 cMid = (i0 + i1)/2;
 	    int32 c0 = MAX(i0, cMid - nClicks/2);
 	    int32 c1 = MIN(i1, cMid + (nClicks+1)/2);
-	    for (int32 ci = c0; ci < c1; ci++)
-		fprintf(fp, ",%.3lf", (allC->timeD[ci] - t0D) * secPerDay);
+	    encRepEnc(&er, round(t0D * secPerDay), round(t1D * secPerDay),
+		      i1 - i0, c1 - c0);
+	    CLICKITER it;
+	    double tD;
+	    char txt[32];
+	    clickIterStart(&it, allC, c0);
+	    for (int32 ci = c0; ci < c1 && clickIterNext(&it, &tD); ci++) {
+		snprintf(txt, sizeof(txt), "%.3lf", (tD - t0D) * secPerDay);
+		fprintf(fp, ",%s", txt);
+		encRepClick(&er, txt);
+	    }
 	    fprintf(fp, "\n");
 	}   //for i
-	fprintf(fp, "$processtimesec,%ld\n", time(NULL) - startTime);
+	long procSec = time(NULL) - startTime;
+	fprintf(fp, "$processtimesec,%ld\n", procSec);
+	encRepProcessTime(&er, procSec);
 	fclose(fp);
     } //if (fp != NULL)
 
+    /* The binary version has the same name with .bin on the end instead. */
+    char binPath[256], wisprBinPath[256], root[256];
+    if (binary) {
+	snprintf(binPath, sizeof(binPath), "%s.bin",
+		 pathRoot(root, piEncDetsPath));
+	snprintf(wisprBinPath, sizeof(wisprBinPath), "%s.bin",
+		 pathRoot(root, wisprEncDetsPath));
+	if (!encRepWrite(&er, binPath)) {
+	    fprintf(stderr, "Can't write %s; listing the CSV\n", binPath);
+	    binary = 0;
+	}
+    }
+    free(er.buf);
+
     /* Write name of that output file to encFileListPath. Use the WISPR version
      * of this name. */
     fp = fopen(encFileListPath, "a");
     if (fp != NULL) {
-	fprintf(fp, "%s\n", pathFile(wisprEncDetsPath));
+	fprintf(fp, "%s\n", pathFile(binary ? wisprBinPath : wisprEncDetsPath));
 	fclose(fp);
     }
 }
+
+#ifdef MAIN
+/* Benchmark findEncounters as the number of clicks and the length of the
+ * mission grow, and check countHits against the old way of counting, which
+ * checked every click against every block. Compile with
+ *
+ *	cc -O3 -DMAIN encounters.c allClicks.c encReport.c ermaGoodies.c -lm
+ *
+ * The old way takes nBlocks*nClicks steps, so it's skipped where that would
+ * take too long. It also checks that finding the encounters over several runs,
+ * with the state saved and read back in between, gives the same encounters as
+ * one run does, once each encounter that was added with an end that later
+ * changed is replaced by the later one.
+ */
+static void oldCountHits(ALLCLICKS *allC, int64 minBlock, int32 nBlocks,
+			 double blocksPerDay, double blockLenD, int32 *nHits)
+{
+    for (int32 i = 0; i < nBlocks; i++) {
+	int32 nn = 0;
+	for (int32 j = 0; j < allC->n; j++)
+	    nn += blockHas(i, minBlock, blocksPerDay, blockLenD,
+			   allClicksTimeD(allC, j));
+	nHits[i] = nn;
+    }
+}
+
+
+static int cmpDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+/* Put the clicks at times tD[j0] to tD[j1-1], in days since the Epoch, into
+ * ac, as if they came from hour-long files. */
+static void fillClicks(ALLCLICKS *ac, double *tD, int32 j0, int32 j1)
+{
+    initALLCLICKS(ac);
+    for (int32 j = j0; j < j1; j++) {
+	double tE = tD[j] * 86400, fileE = floor(tE / 3600) * 3600;
+	allClicksAdd(ac, fileE, tE - fileE);
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int32 nClicksList[] = { 1000, 10000, 100000, 1000000 };
+    float daysList[] = { 1, 10, 100 };
+    ERMAPARAMS ep;
+    ep.blockLenS = 60;
+    ep.clicksPerBlock = 15;
+    ep.consecBlocks = 10;
+    ep.hitsPerEnc = 5;
+
+    srand48(1);
+    for (int di = 0; di < NUM_OF(daysList); di++) {
+	for (int ci = 0; ci < NUM_OF(nClicksList); ci++) {
+	    /* Make clicks about 1 s apart in half-hour encounters spread over
+	     * the mission, starting at 12:00 on 10 June 2017. When they're
+	     * crowded, encounters can overlap. */
+	    float days = daysList[di];
+	    int32 n = nClicksList[ci];
+	    double t0D = 17327.5;
+	    ALLCLICKS ac;
+	    double *tD = malloc(n * sizeof(double));
+	    int32 perEnc = 1800;
+	    int32 nEnc = (n + perEnc - 1) / perEnc;
+	    double encT0 = t0D;
+	    for (int32 j = 0; j < n; j++) {
+		if (j % perEnc == 0)
+		    encT0 = t0D + (j / perEnc + drand48() * 0.5) * days / nEnc;
+		tD[j] = encT0 + ((j % perEnc) + drand48()) / 86400.0;
+	    }
+	    qsort(tD, n, sizeof(tD[0]), cmpDouble);
+	    fillClicks(&ac, tD, 0, n);
+
+	    //Count the hits both ways.
+	    double blocksPerDay = 86400.0 / ep.blockLenS;
+	    int64 minBlock = floor(t0D * blocksPerDay);
+	    int32 nBlocks = ceil((t0D + days + 0.1) * blocksPerDay) - minBlock;
+	    int32 *h0 = malloc(nBlocks * sizeof(int32));
+	    int32 *h1 = malloc(nBlocks * sizeof(int32));
+	    double t = nowSec();
+	    countHits(&ac, 0, minBlock, nBlocks, blocksPerDay, 1/blocksPerDay,
+		      h1);
+	    double newSec = nowSec() - t;
+	    double oldSec = -1;
+	    int same = 1;
+	    if ((double)nBlocks * n < 2e9) {
+		t = nowSec();
+		oldCountHits(&ac, minBlock, nBlocks, blocksPerDay,
+			     1/blocksPerDay, h0);
+		oldSec = nowSec() - t;
+		same = !memcmp(h0, h1, nBlocks * sizeof(int32));
+	    }
+
+	    //Time all of findEncounters.
+	    ENCOUNTERS enc;
+	    ENCSTATE es;
+	    initENCOUNTERS(&enc);
+	    initENCSTATE(&es);
+	    resetENCSTATE(&es, &ep);
+	    t = nowSec();
+	    findEncounters(&ac, &ep, &es, &enc);
+	    finishEncounters(&es, &ep, &enc);
+	    double encSec = nowSec() - t;
+
+	    //Do it again in 7 runs, as if over several dives.
+	    ENCOUNTERS enc2;
+	    initENCOUNTERS(&enc2);
+	    resetENCSTATE(&es, &ep);
+	    char *path = "temp-encounter_state";
+	    for (int32 r = 0, j0 = 0; r < 7; r++) {
+		int32 j1 = (int64)n * (r + 1) / 7;
+		ALLCLICKS runC;
+		fillClicks(&runC, tD, j0, j1);
+		es.nDone = 0;
+		findEncounters(&runC, &ep, &es, &enc2);
+		finishEncounters(&es, &ep, &enc2);
+		freeALLCLICKS(&runC);
+		encStateWrite(&es, path);
+		encStateRead(&es, &ep, path);
+		j0 = j1;
+	    }
+	    remove(path);
+	    int32 m = 0;			//enc2 with superseded ones removed
+	    for (int32 k = 0; k < enc2.n; k++) {
+		if (m > 0 && enc2.tSpanD[k].t0 == enc2.tSpanD[m-1].t0)
+		    m--;
+		enc2.tSpanD[m++] = enc2.tSpanD[k];
+	    }
+	    same &= (m == enc.n && !memcmp(enc.tSpanD, enc2.tSpanD,
+					   m * sizeof(enc.tSpanD[0])));
+
+	    printf("%5.0f days, %7d clicks: countHits %8.3f ms, old way ",
+		   days, n, newSec * 1e3);
+	    if (oldSec < 0)
+		printf("  (skipped)");
+	    else
+		printf("%10.3f ms", oldSec * 1e3);
+	    printf(", findEncounters %8.3f ms%s\n", encSec * 1e3,
+		   same ? "" : "  MISMATCH!");
+	    free(h0);
+	    free(h1);
+	    free(tD);
+	    freeALLCLICKS(&ac);
+	    free(enc.tSpanD);
+	    free(enc2.tSpanD);
+	}
+    }
+    return 0;
+}
+#endif	/* MAIN */
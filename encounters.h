@@ -11,11 +11,38 @@ typedef struct {
     int32 n;	    	//number of valid elements in tSpanD
 } ENCOUNTERS;
 
+/* An ENCSTATE has what findEncounters needs to carry on where it left off,
+ * which might be in an earlier run (e.g., the last dive): the hit flags of the
+ * most recent blocks, and whether an encounter is under way. Blocks are
+ * numbered from the Epoch. It's kept between runs in a small file; see
+ * encStateRead.
+ */
+typedef struct {
+    float blockLenS;	//ep->blockLenS it was made with
+    int32 nWin;		//ep->consecBlocks, as a whole number
+    int32 *isHit;	//hit flags of blocks curBlock-nWin-1 .. curBlock-1, in
+    size_t isHitSize;	//  a ring indexed by block # mod (nWin+1); for bufgrow
+    int64 curBlock;	//newest block, which may still get clicks; -1 if none
+    int32 curClicks;	//number of clicks in curBlock so far
+    int32 nInConsec;	//number of hits in the nWin blocks before curBlock
+    int inEnc;		//in an encounter?
+    int64 encStartBlk;	//start block # of encounter under way
+    int64 repStartBlk;	//start and end block #s of the encounter most
+    int64 repEndBlk;	//  recently added to an ENCOUNTERS, or -1
+    int32 nDone;	//number of clicks in allC already counted (this run)
+} ENCSTATE;
+
 void initENCOUNTERS(ENCOUNTERS *enc);
-void findEncounters(ALLCLICKS *allClicks, ERMAPARAMS *ep, ENCOUNTERS *enc);
+void initENCSTATE(ENCSTATE *es);
+void resetENCSTATE(ENCSTATE *es, ERMAPARAMS *ep);
+void findEncounters(ALLCLICKS *allC, ERMAPARAMS *ep, ENCSTATE *es,
+		    ENCOUNTERS *enc);
+void finishEncounters(ENCSTATE *es, ERMAPARAMS *ep, ENCOUNTERS *enc);
+void encStateRead(ENCSTATE *es, ERMAPARAMS *ep, char *path);
+void encStateWrite(ENCSTATE *es, char *path);
 void saveEncounters(ENCOUNTERS *enc, ALLCLICKS *allC, char *piEncDetsPath,
 		    char *wisprEncDetsPath, double tMinE, double tMaxE,
 		    char *encFileListPath, int32 clicksToSave,
-		    time_t startTime);
+		    time_t startTime, int binary);
 
 #endif /* _ENCOUNTERS_H_ */
@@ -19,7 +19,11 @@
 #include <sys/param.h>		/* for MIN and MAX */
 #include <dirent.h>
 #include <glob.h>
+#include <fnmatch.h>
 #include <float.h>
+#include <fcntl.h>		/* for open() */
+#include <sys/mman.h>		/* for mmap() */
+#include <stddef.h>		/* for offsetof */
 
 
 /* About times in this ERMA project:
@@ -106,8 +110,17 @@ typedef union {
 #include "ermaFilt.h"
 #include "quietTimes.h"
 #include "ermaNew.h"
+#include "allClicks.h"
+#include "clickLog.h"
+#include "clickSpec.h"
 #include "processFile.h"
 #include "encounters.h"
+#include "encReport.h"
+#include "journal.h"
+#include "allDetsBin.h"
+#include "dirScan.h"
+#include "ermaProfile.h"
+#include "ermaSweep.h"
 #include "expDecay.h"
 
 #endif	/* _ERMA_H_ */
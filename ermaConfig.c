@@ -114,6 +114,38 @@ static void allocFilterCoeffs(int32 n, float **pA, float **pB)
 }
 
 
+/* Give ep its own copies of its filter coefficient arrays, so that changing
+ * them (as gatherErmaParams does for a profile that gives numerA without
+ * numerN, say) doesn't change the arrays of the ERMAPARAMS it was copied from.
+ */
+void copyFilterCoeffs(ERMAPARAMS *ep)
+{
+    float *a, *b;
+
+    allocFilterCoeffs(ep->dsfN, &a, &b);
+    if (ep->dsfN > 0) {
+	memcpy(a, ep->dsfA, ep->dsfN * sizeof(a[0]));
+	memcpy(b, ep->dsfB, ep->dsfN * sizeof(b[0]));
+	ep->dsfA = a;
+	ep->dsfB = b;
+    }
+    allocFilterCoeffs(ep->numerN, &a, &b);
+    if (ep->numerN > 0) {
+	memcpy(a, ep->numerA, ep->numerN * sizeof(a[0]));
+	memcpy(b, ep->numerB, ep->numerN * sizeof(b[0]));
+	ep->numerA = a;
+	ep->numerB = b;
+    }
+    allocFilterCoeffs(ep->denomN, &a, &b);
+    if (ep->denomN > 0) {
+	memcpy(a, ep->denomA, ep->denomN * sizeof(a[0]));
+	memcpy(b, ep->denomB, ep->denomN * sizeof(b[0]));
+	ep->denomA = a;
+	ep->denomB = b;
+    }
+}
+
+
 /* Convert each string in an ERMACONFIG into its corresponding value as a
  * float/int32/whatever in an ERMAPARAMS. Any members of the ERMAPARAMS that
  * didn't have anything specified for them in the ERMACONFIG (i.e., in the
@@ -136,6 +168,10 @@ void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep)
     ermaGetString(ec, "allDetsPrefix",	&ep->allDetsPrefix);
     ermaGetString(ec, "encDetsPrefix",	&ep->encDetsPrefix);
     ermaGetString(ec, "pctFileName",	&ep->pctFileName);
+    ermaGetString(ec, "encStateFileName",&ep->encStateFileName);
+    ermaGetString(ec, "clickLogFileName",&ep->clickLogFileName);
+    ermaGetString(ec, "journalFileName",&ep->journalFileName);
+    ermaGetString(ec, "dirScanFileName",&ep->dirScanFileName);
 
     /* GPIO pins */
     ermaGetInt32(ec, "gpioWisprActive", &ep->gpioWisprActive);
@@ -143,13 +179,15 @@ void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep)
 
     /* Stuff for filtering: */
     /* These 'N' params must be read before the corresponding A and B ones so
-     * allocFilterCoeffs can be called to allocate space for the A/B arrays */
-    ermaGetInt32     (ec, "dsfN",   &ep->dsfN);	/* before dsfA/B! */
-    ermaGetInt32     (ec, "numerN", &ep->numerN);	/* before numerA/B! */
-    ermaGetInt32     (ec, "denomN", &ep->denomN);	/* before denomA/B! */
-    allocFilterCoeffs(ep->dsfN,     &ep->dsfA,   &ep->dsfB);
-    allocFilterCoeffs(ep->numerN,   &ep->numerA, &ep->numerB);
-    allocFilterCoeffs(ep->denomN,   &ep->denomA, &ep->denomB);
+     * allocFilterCoeffs can be called to allocate space for the A/B arrays.
+     * Space is allocated only if the N is in ec, so a profile (see
+     * ermaProfile.c) that doesn't give new filters keeps the ones it has. */
+    if (ermaGetInt32(ec, "dsfN",   &ep->dsfN))	/* before dsfA/B! */
+	allocFilterCoeffs(ep->dsfN,   &ep->dsfA,   &ep->dsfB);
+    if (ermaGetInt32(ec, "numerN", &ep->numerN))	/* before numerA/B! */
+	allocFilterCoeffs(ep->numerN, &ep->numerA, &ep->numerB);
+    if (ermaGetInt32(ec, "denomN", &ep->denomN))	/* before denomA/B! */
+	allocFilterCoeffs(ep->denomN, &ep->denomA, &ep->denomB);
     ermaGetFloatArray(ec, "dsfA",   ep->dsfA,   ep->dsfN);
     ermaGetFloatArray(ec, "dsfB",   ep->dsfB,   ep->dsfN);
     ermaGetFloatArray(ec, "numerA", ep->numerA, ep->numerN);
@@ -157,6 +195,8 @@ void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep)
     ermaGetFloatArray(ec, "denomA", ep->denomA, ep->denomN);
     ermaGetFloatArray(ec, "denomB", ep->denomB, ep->denomN);
     ermaGetInt32     (ec, "decim",  &ep->decim);
+    ermaGetFloatArray(ec, "numerBand", ep->numerBand, NUM_OF(ep->numerBand));
+    ermaGetFloatArray(ec, "denomBand", ep->denomBand, NUM_OF(ep->denomBand));
 
     /* stuff for ERMA algorithm: */
     ermaGetFloat(ec, "decayTime",	&ep->decayTime);
@@ -169,6 +209,13 @@ void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep)
     ermaGetFloat(ec, "ignoreThresh",	&ep->ignoreThresh);
     ermaGetFloat(ec, "ignoreLimT",	&ep->ignoreLimT);
     ermaGetFloat(ec, "specLenS",	&ep->specLenS);
+    ermaGetFloat(ec, "contMaxGapS",	&ep->contMaxGapS);
+    ermaGetFloat(ec, "warmupS",		&ep->warmupS);
+    ermaGetFloat(ec, "gateThresh",	&ep->gateThresh);
+    ermaGetFloat(ec, "gateWinS",	&ep->gateWinS);
+    ermaGetInt32(ec, "gateDecim",	&ep->gateDecim);
+    ermaGetFloat(ec, "gateFreq",	&ep->gateFreq);
+    ermaGetFloat(ec, "gateMarginS",	&ep->gateMarginS);
 
     /* stuff for testClickDets: */
     ermaGetFloat(ec, "minRate",		&ep->minRate);
@@ -182,6 +229,7 @@ void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep)
     ermaGetFloat(ec, "consecBlocks",	&ep->consecBlocks);
     ermaGetFloat(ec, "hitsPerEnc",	&ep->hitsPerEnc);
     ermaGetInt32(ec, "clicksToSave",	&ep->clicksToSave);
+    ermaGetInt32(ec, "encBinary",	&ep->encBinary);
     
     /* stuff for glider noise removal: */
     ermaGetFloat(ec, "ns_tBlockS",	&ep->ns_tBlockS);
@@ -189,8 +237,17 @@ void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep)
     ermaGetFloat(ec, "ns_pctile",	&ep->ns_pctile);
     ermaGetInt32(ec, "ns_nRecent",	&ep->ns_nRecent);
     ermaGetFloat(ec, "ns_medianMult",	&ep->ns_medianMult);
+    ermaGetInt32(ec, "ns_saveEvery",	&ep->ns_saveEvery);
     /*ermaGetFloat(ec, "ns_thresh",	&ep->ns_thresh);*/ //obsolete
     ermaGetFloat(ec, "ns_padSec",	&ep->ns_padSec);
+    ermaGetInt32(ec, "ns_decimate",	&ep->ns_decimate);
+    ermaGetFloat(ec, "ns_onlineChunkS",	&ep->ns_onlineChunkS);
+
+    /* stuff for bookkeeping: */
+    ermaGetInt32(ec, "journalSyncFiles",&ep->journalSyncFiles);
+    ermaGetFloat(ec, "journalSyncS",	&ep->journalSyncS);
+    ermaGetInt32(ec, "allDetsBinary",	&ep->allDetsBinary);
+    ermaGetInt32(ec, "allDetsSpectra",	&ep->allDetsSpectra);
 }
 
 
@@ -218,7 +275,13 @@ int ermaGetInt32(ERMACONFIG *ec, char *varname, int32 *val)
     if (foundValueStr == NULL)
 	return 0;
 
-    return (sscanf(foundValueStr, "%ld", val) == 1);
+    /* Scan into a long, as %ld into an int32 writes past it where long is 64
+     * bits. */
+    long lval;
+    if (sscanf(foundValueStr, "%ld", &lval) != 1)
+	return 0;
+    *val = (int32)lval;
+    return 1;
 }
 
 
@@ -289,8 +352,8 @@ int ermaGetFloatArray(ERMACONFIG *ec, char *varname, float *val, int32 arrLen)
     int32 pos = 0;
     for (int32 i = 0; i < arrLen; i++) {
 	/* scan the next float in the sequence */
-	if (sscanf(&foundValueStr[pos], "%f%n", &val[i], &nScan) == 0)
-	    return i;
+	if (sscanf(&foundValueStr[pos], "%f%n", &val[i], &nScan) != 1)
+	    return i;		//sscanf gives EOF, not 0, at end of string
 	pos += nScan;
 	/* swallow the ',' if any */
 	sscanf(&foundValueStr[pos], "%n,%n", &nScan, &nScan);
@@ -35,6 +35,10 @@ typedef struct
     char *allDetsPrefix;//prefix for files holding times of all clicks detected
     char *encDetsPrefix;//prefix for files holding times of dets in encounters
     char *pctFileName;	//for storing recent 10th-percentile values
+    char *encStateFileName;//for carrying encounter state between runs
+    char *clickLogFileName;//binary log of all clicks ever; "" means none
+    char *journalFileName;//bookkeeping journal; "" means none
+    char *dirScanFileName;//directories with nothing new; "" means none
 
     /* GPIO pins: */
     int32 gpioWisprActive;//input pin # to tell RPi to process files
@@ -48,6 +52,8 @@ typedef struct
     int32 numerN;	//length of dsfA and dsfB (= filter order + 1)
     float *denomA, *denomB; //IIR filter coefficients for denominator filter
     int32 denomN;	//length of dsfA and dsfB (= filter order + 1)
+    float numerBand[2];	//passband of numerA/B, Hz; {0,0} means default
+    float denomBand[2];	//passband of denomA/B, Hz; {0,0} means default
 
     /* stuff for ERMA algorithm: */
     float decayTime;	//exponential-decay constant for expdecay()
@@ -60,6 +66,13 @@ typedef struct
     float ignoreThresh;	//sams this loud don't affect running mean
     float ignoreLimT;	//...unless they last for this long
     float specLenS;	//time window for calculating averaged click spectra
+    float contMaxGapS;	//max gap between files for carrying DSP state over
+    float warmupS;	//don't detect in this much of a segment after a reset
+    float gateThresh;	//energy gate: pass windows this * median; 0 = no gate
+    float gateWinS;	//energy gate window length, s
+    int32 gateDecim;	//energy gate uses every gateDecim'th sample
+    float gateFreq;	//energy gate is most sensitive at this frequency, Hz
+    float gateMarginS;	//run ERMA this long before a window the gate passes
 
     /* stuff for testClickDets: */
     float minRate;	//min req'd click period over whole file, s
@@ -74,6 +87,7 @@ typedef struct
     float hitsPerEnc;	//min number of block hits in consecutive
       			//blocks needed to count as an encounter
     int32 clicksToSave;	//number of clicks per encounter to save
+    int32 encBinary;	//1 = list a binary encounter report, not the CSV
     
     /* stuff for glider noise removal: */
     float ns_tBlockS;	//block duration for measuring noise, s
@@ -81,9 +95,20 @@ typedef struct
     float ns_pctile;	//percentile for measuring background noise level
     int32 ns_nRecent;	//number of recent ns_pctile values to get median of
     float ns_medianMult;//thresh = this * (median of recent ns_pctile values)
+    int32 ns_saveEvery;	//save recent ns_pctile values every this many files
     //float ns_thresh;	//noise threshold
     float ns_padSec;  	//pad noise periods w/this for ramp up/down
     float ns_minQuietS;	//minimum length of a noise section
+    int32 ns_decimate;	//1 = find quiet times from every decim'th sample
+    float ns_onlineChunkS;//>0: find quiet times while reading file in chunks
+
+    /* stuff for bookkeeping: */
+    int32 journalSyncFiles;//fsync the journal every this many files...
+    float journalSyncS;	//...or this many seconds
+
+    /* stuff for all_dets output: */
+    int32 allDetsBinary;//1 = binary all_dets too, 2 = binary instead of CSV
+    int32 allDetsSpectra;//1 = click spectra go in the binary all_dets too
 } ERMAPARAMS;
 
 
@@ -92,6 +117,7 @@ void deleteERMACONFIG(ERMACONFIG *ec);
 void printERMACONFIG(ERMACONFIG *ec);
 ERMACONFIG *ermaReadConfigFile(char *dir, char *filename);
 void gatherErmaParams(ERMACONFIG *ec, ERMAPARAMS *ep);
+void copyFilterCoeffs(ERMAPARAMS *ep);
 char *ermaFindVar(ERMACONFIG *ec, char *varname);
 
 /* These are for scanning ERMACONFIGs for a given varname and interpreting its
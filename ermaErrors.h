@@ -11,7 +11,7 @@
 #define ERMA_NO_MEMORY_CONFIGVARBUF	5	/* ermaConfig.c */
 #define ERMA_NO_MEMORY_CONFIGVAR	6	/* ermaConfig.c */
 #define ERMA_NO_MEMORY_FILELIST		7	/* ErmaMain.c */
-#define ERMA_NO_MEMORY_UNPROCESSED	8	/* ErmaMain.c */
+#define ERMA_NO_MEMORY_UNPROCESSED	8	/* dirScan.c */
 #define ERMA_NO_MEMORY_AVGPOWER		9	/* findQuiet.c */
 #define ERMA_NO_MEMORY_QUIETTIME	10	/* findQuiet.c */
 #define ERMA_NO_MEMORY_WISPR_SNDBUF	11	/* wisprFile.c */
@@ -34,5 +34,19 @@
 #define ERMA_NO_MEMORY_READFLOATS	28	/* ermaGoodies.c */
 #define ERMA_NO_MEMORY_GETTHRESH	29	/* quietTimes.c */
 #define CANT_DO_WINDOW_TYPE		30	/* fft.c */
+#define ERMA_NO_MEMORY_CLICKSPEC	31	/* clickSpec.c */
+#define ERMA_NO_MEMORY_PROFILE		32	/* ermaProfile.c */
+#define ERMA_NO_MEMORY_SWEEP		33	/* ermaSweep.c */
+#define ERMA_SWEEP_BAD_PROFILE		34	/* ermaSweep.c */
+#define ERMA_SWEEP_CANT_WRITE		35	/* ermaSweep.c */
+#define ERMA_NO_MEMORY_GATE		36	/* ermaNew.c */
+#define ERMA_NO_MEMORY_CLICKLOG		37	/* clickLog.c */
+#define ERMA_CLICKLOG_BAD_ARGS		38	/* clickLog.c */
+#define ERMA_ENCREP_BAD_FILE		39	/* encReport.c */
+#define ERMA_NO_MEMORY_JOURNAL		40	/* journal.c */
+#define ERMA_NO_MEMORY_ALLDETSBIN	41	/* allDetsBin.c */
+#define ERMA_ALLDETSBIN_BAD_FILE	42	/* ermaExport.c */
+#define ERMA_NO_MEMORY_STRSET		43	/* ermaGoodies.c */
+#define ERMA_NO_MEMORY_DIRSCAN		44	/* dirScan.c */
 
 #endif	/* _ERMAERRORS_H */
@@ -0,0 +1,101 @@
+
+#include "erma.h"
+
+/* ermaExport turns a binary all_dets file (see allDetsBin.h) back into the
+ * all_dets CSV that ErmaMain writes:
+ *
+ *	ermaExport [-peaks] all_dets-XXX.bin [out.csv]
+ *
+ * The CSV goes to out.csv, or to stdout if it's not given. It's the same, byte
+ * for byte, as the $clickDet lines ErmaMain writes for the same clicks. With
+ * -peaks, the CSV has a line per click instead, with its file, its time in s
+ * since the Epoch, and the ratio and numerator power at its peak.
+ */
+
+static char *usage = "Usage: ermaExport [-peaks] all_dets.bin [out.csv]\n";
+
+
+/* Write the $clickDet line for the clicks in block b to out. The line is
+ * formatted as in saveNewClicks (ermaNew.c), with the same arithmetic, which
+ * goes by way of days since the Epoch as ALLCLICKS does (see allClicks.h).
+ */
+static void exportClickDet(ALLDETSBLOCK *b, FILE *out)
+{
+    const double secPerDay = 24*60*60;
+    ALLDETSHEAD *h = b->head;
+    char buf[32];
+
+    double baseTime_D = h->fileTimeE / secPerDay;
+    fprintf(out, "$clickDet,%.*s,%.3lf", (int)h->nameLen, b->name,
+	    baseTime_D * secPerDay);
+    for (uint32 i = 0; i < h->nClick; i++) {
+	double tD = ((double)b->timeS[i] + h->fileTimeE) / secPerDay;
+	char *p = putMillis(buf, (tD - baseTime_D) * secPerDay);
+	fwrite(buf, 1, p - buf, out);
+    }
+    fputc('\n', out);
+}
+
+
+/* Write one line per click in block b to out, giving its peaks. */
+static void exportPeaks(ALLDETSBLOCK *b, FILE *out)
+{
+    ALLDETSHEAD *h = b->head;
+
+    for (uint32 i = 0; i < h->nClick; i++)
+	fprintf(out, "%.*s,%.6lf,%.4g,%.4g\n", (int)h->nameLen, b->name,
+		(double)b->timeS[i] + h->fileTimeE,
+		b->ratioPk[i], b->numerPk[i]);
+}
+
+
+int main(int argc, char **argv)
+{
+    int peaks = (argc > 1 && !strcmp(argv[1], "-peaks"));
+    int nArgs = argc - 1 - peaks;
+    char **args = argv + 1 + peaks;
+
+    if (nArgs < 1 || nArgs > 2) {
+	fprintf(stderr, "%s", usage);
+	return ERMA_ALLDETSBIN_BAD_FILE;
+    }
+    int fd = open(args[0], O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+	fprintf(stderr, "Can't open %s\n", args[0]);
+	return ERMA_ALLDETSBIN_BAD_FILE;
+    }
+    size_t n = st.st_size;
+    void *buf = (n == 0) ? NULL
+	: mmap(NULL, n, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (buf == MAP_FAILED) {
+	fprintf(stderr, "Can't read %s\n", args[0]);
+	return ERMA_ALLDETSBIN_BAD_FILE;
+    }
+    FILE *out = (nArgs > 1) ? fopen(args[1], "w") : stdout;
+    if (out == NULL) {
+	fprintf(stderr, "Can't open %s\n", args[1]);
+	return ERMA_ALLDETSBIN_BAD_FILE;
+    }
+    if (peaks)
+	fprintf(out, "file,timeE,ratioPk,numerPk\n");
+
+    ALLDETSBLOCK b;
+    size_t pos = 0;
+    while (allDetsBinNext(buf, n, &pos, &b))
+	if (peaks)
+	    exportPeaks(&b, out);
+	else
+	    exportClickDet(&b, out);
+
+    if (out != stdout)
+	fclose(out);
+    if (n > 0)
+	munmap(buf, n);
+    if (pos < n) {
+	fprintf(stderr, "%s is bad from byte %zu on\n", args[0], pos);
+	return ERMA_ALLDETSBIN_BAD_FILE;
+    }
+    return 0;
+}
@@ -104,16 +104,6 @@ IIRFILTER numerFilter_60kHz =
       numerB_60kHz, numerA_60kHz,//B, A
       NULL, NULL		//B1, A1
     };
-/* This is the filter that is actually used for the numerator. It receives a
- * copy of either numerFilter_60kHz, numerFilter_50kHz, or one the user
- * specified in rpi.cnf.
- */
-IIRFILTER numerFilter =
-    { { 0.0, 0.0 },		//passband, Hz
-      0,			//n: length of B and A
-      NULL, NULL,		//B, A
-      NULL, NULL		//B1, A1
-    };
 
 
 /* This filter is for the denominator - the "guard band" - of the ERMA
@@ -153,32 +143,22 @@ IIRFILTER denomFilter_50kHz =
       denomB_50kHz, denomA_50kHz,//B, A
       NULL, NULL		//B1, A1
     };
-
-/* This is the filter that is actually used for the denominator. It receives a
- * copy of either denomFilter_60kHz, denomFilter_50kHz, or one the user
- * specified in rpi.cnf.
- */
-IIRFILTER denomFilter =
-    { { 0.0, 0.0 },		//passband, Hz
-      0,			//n: length of B and A
-      NULL, NULL,		//B, A
-      NULL, NULL		//B1, A1
-    };
 			 
 /************************ end of filter definitions **************************/
 
 
-/* Define the warmup vectors. These CANNOT be reused if there are multiple
- * instances of a given filter running - each filter run needs its own.
+/* Define the warmup vector for the downsampling filter. This CANNOT be reused
+ * if there are multiple instances of a given filter running - each filter run
+ * needs its own. The numerator and denominator filters keep theirs in an
+ * ERMAFILT, one per detector profile.
  */
 float *downsampleWarmup = NULL;
-float *numerWarmup_60kHz = NULL, *denomWarmup_60kHz = NULL, *numerWarmup = NULL;
-float *numerWarmup_50kHz = NULL, *denomWarmup_50kHz = NULL, *denomWarmup = NULL;
 
-/* Prepare filters for use: install params from the ERMAPARAMS if they were
- * specified in rpi.cnf (if they weren't, ep->dsfA/numerA/denomA will be NULL
- * and the corresponding n is 0). Then set the B1 and A1 vectors in each filter
- * via initIirFilter.
+/* Prepare the downsampling filter for use: install params from the ERMAPARAMS
+ * if they were specified in rpi.cnf (if they weren't, ep->dsfA will be NULL and
+ * ep->dsfN is 0). Then set the B1 and A1 vectors via initIirFilter. The
+ * numerator and denominator filters are set up separately for each profile by
+ * ermaFiltInit.
  */
 void ermaFiltPrep(ERMAPARAMS *ep)
 {
@@ -192,39 +172,99 @@ void ermaFiltPrep(ERMAPARAMS *ep)
 	downsampleFilter.A1 = calloc(ep->dsfN, sizeof(downsampleFilter.A1[0]));
     }
 
-    /* Prepare the ERMA numerator filter */
+    /* Construct the B1 and A1 coefficients. */
+    if (initIirFilter(&downsampleFilter, &downsampleWarmup))
+	exit(ERMA_NO_MEMORY_FILTER_WARMUP);
+}
+
+
+/* Clear a filter's warmup vector, which holds its state, so the next call to
+ * iirFilter starts as if on a new signal. warmup may be NULL if the filter
+ * hasn't been set up yet.
+ */
+static void clearWarmup(IIRFILTER *iif, float *warmup)
+{
+    if (warmup != NULL)
+	memset(warmup, 0, 2 * iif->n * sizeof(warmup[0]));
+}
+
+
+/* Reset the downsampling filter's state, for when the next signal doesn't
+ * continue on from the last one.
+ */
+void ermaFiltResetDownsample(void)
+{
+    clearWarmup(&downsampleFilter, downsampleWarmup);
+}
+
+
+/* Reset the state of the numerator and denominator filters in ef, likewise.
+ */
+void ermaFiltReset(ERMAFILT *ef)
+{
+    clearWarmup(&ef->numer, ef->numerWarmup);
+    clearWarmup(&ef->denom, ef->denomWarmup);
+}
+
+
+/* Prepare an ERMAFILT for use by one detector profile. If the profile's
+ * ERMAPARAMS has numerator or denominator filter coefficients from rpi.cnf,
+ * they're installed here; otherwise that filter is left empty, and a default
+ * one is picked according to the sample rate on the first call to
+ * ermaNumerDenomFilt.
+ */
+void ermaFiltInit(ERMAFILT *ef, ERMAPARAMS *ep)
+{
+    IIRFILTER empty = { { 0.0, 0.0 }, 0, NULL, NULL, NULL, NULL };
+
+    ef->numer = ef->denom = empty;
+    ef->numerWarmup = ef->denomWarmup = NULL;
+
     if (ep->numerN > 0 && ep->numerA != NULL && ep->numerB != NULL) {
-	numerFilter.B = ep->numerB;
-	numerFilter.A = ep->numerA;
-	numerFilter.n = ep->numerN;
-	/* B1 and A1 get made from B and A, so need to remake them too */
-	numerFilter.B1 = calloc(ep->dsfN, sizeof(numerFilter.B1[0]));
-	numerFilter.A1 = calloc(ep->dsfN, sizeof(numerFilter.A1[0]));
+	ef->numer.B = ep->numerB;
+	ef->numer.A = ep->numerA;
+	ef->numer.n = ep->numerN;
+	ef->numer.passband[0] = ep->numerBand[0];
+	ef->numer.passband[1] = ep->numerBand[1];
+	if (initIirFilter(&ef->numer, &ef->numerWarmup))
+	    exit(ERMA_NO_MEMORY_FILTER_WARMUP);
     }
-
-    /* Prepare the ERMA denominator filter */
     if (ep->denomN > 0 && ep->denomA != NULL && ep->denomB != NULL) {
-	denomFilter.B = ep->denomB;
-	denomFilter.A = ep->denomA;
-	denomFilter.n = ep->denomN;
-	/* B1 and A1 get made from B and A, so need to remake them too */
-	denomFilter.B1 = calloc(ep->dsfN, sizeof(denomFilter.B1[0]));
-	denomFilter.A1 = calloc(ep->dsfN, sizeof(denomFilter.A1[0]));
+	ef->denom.B = ep->denomB;
+	ef->denom.A = ep->denomA;
+	ef->denom.n = ep->denomN;
+	ef->denom.passband[0] = ep->denomBand[0];
+	ef->denom.passband[1] = ep->denomBand[1];
+	if (initIirFilter(&ef->denom, &ef->denomWarmup))
+	    exit(ERMA_NO_MEMORY_FILTER_WARMUP);
     }
+}
 
-    /* Construct the B1 and A1 coefficients in each filter. */
-    if (initIirFilter(&downsampleFilter,  &downsampleWarmup) ||
-	initIirFilter(&numerFilter_60kHz, &numerWarmup_60kHz)      ||
-	initIirFilter(&numerFilter_50kHz, &numerWarmup_50kHz)      ||
-	initIirFilter(&denomFilter_60kHz, &denomWarmup_60kHz)      ||
-	initIirFilter(&denomFilter_50kHz, &denomWarmup_50kHz)        )
-	exit(ERMA_NO_MEMORY_FILTER_WARMUP);
+
+/* If *dst has no coefficients yet, install a copy of the default filter dflt
+ * in it with its own B1, A1, and warmup. If *dst doesn't have a passband (i.e.,
+ * none was given in rpi.cnf), it gets the default filter's passband.
+ */
+static void pickFilter(IIRFILTER *dst, float **pWarmup, IIRFILTER *dflt)
+{
+    if (dst->B == NULL || dst->A == NULL || dst->n < 1) {
+	*dst = *dflt;
+	dst->B1 = dst->A1 = NULL;
+	*pWarmup = NULL;
+	if (initIirFilter(dst, pWarmup))
+	    exit(ERMA_NO_MEMORY_FILTER_WARMUP);
+    }
+    if (dst->passband[1] <= dst->passband[0]) {
+	dst->passband[0] = dflt->passband[0];
+	dst->passband[1] = dflt->passband[1];
+    }
 }
 
 
 /* Downsample a signal by a factor of decim, first lowpass-filtering it so it
  * doesn't alias. Y must be pre-allocated as long as nX. Returns the length of
- * the new signal (= floor(nX/decim)) in *pNY.
+ * the new signal (= floor(nX/decim)) in *pNY. There's only one downsampling
+ * filter, shared by all detector profiles.
  */
 void ermaDownsample(float *X,  int32_t nX,		//in
 		    int32 decim,				//in
@@ -251,52 +291,36 @@ void ermaDownsample(float *X,  int32_t nX,		//in
 	*pNY = nX;
 	*pOutSRate = inSRate;
     }
-    
-    //If the 60 vs. 50 kHz filter hasn't been picked yet, do that. This could
-    //get done below in ermaNumerDenomFilt, but we have the sample rate here and
-    //don't there. First check whether B, A, and n are set, which might have
-    //happened on a previous call here or else were set by user in rpi.cnf.
-    if (numerFilter.B == NULL || numerFilter.A == NULL || numerFilter.n < 1) {
-	if (inSRate < 55000) {
-	    //sRate is closer to 50 kHz than 60 kHz.
-	    numerFilter = numerFilter_50kHz;
-	    numerWarmup = numerWarmup_50kHz;
-	} else {
-	    //sRate is closer to 60 kHz than 50 kHz.
-	    numerFilter = numerFilter_60kHz;
-	    numerWarmup = numerWarmup_60kHz;
-	}
-    }
-    if (denomFilter.B == NULL || denomFilter.A == NULL || denomFilter.n < 1) {
-	if (inSRate < 55000) {
-	    //sRate is closer to 50 kHz than 60 kHz.
-	    denomFilter = denomFilter_50kHz;
-	    denomWarmup = denomWarmup_50kHz;
-	} else {
-	    //sRate is closer to 60 kHz than 50 kHz.
-	    denomFilter = denomFilter_60kHz;
-	    denomWarmup = denomWarmup_60kHz;
-	}
-    }
 }
 
 
-/* Run the numerator and denominator filters for the ERMA calculation on the
- * input signal X. Results are put in numer and denom, which should be at least
- * as long as X.
+/* Run the numerator and denominator filters in ef for the ERMA calculation on
+ * the input signal X. Results are put in numer and denom, which should be at
+ * least as long as X. origSRate is the sample rate of the signal before
+ * ermaDownsample; it's used to pick the 60 vs. 50 kHz default filters.
  */
-void ermaNumerDenomFilt(float *X, int32 nX,		//in
+void ermaNumerDenomFilt(ERMAFILT *ef, float origSRate,	//in & out, in
+			float *X, int32 nX,		//in
 			float *numer, float *denom)	//out
 {
-    iirFilter(&numerFilter, X, nX, numerWarmup, numer);
-    iirFilter(&denomFilter, X, nX, denomWarmup, denom);
+    //If the 60 vs. 50 kHz filter hasn't been picked yet, do that. First check
+    //whether B, A, and n are set, which might have happened on a previous call
+    //here or else were set by user in rpi.cnf.
+    int is50 = (origSRate < 55000);	//sRate closer to 50 kHz than 60 kHz?
+    pickFilter(&ef->numer, &ef->numerWarmup,
+	       is50 ? &numerFilter_50kHz : &numerFilter_60kHz);
+    pickFilter(&ef->denom, &ef->denomWarmup,
+	       is50 ? &denomFilter_50kHz : &denomFilter_60kHz);
+
+    iirFilter(&ef->numer, X, nX, ef->numerWarmup, numer);
+    iirFilter(&ef->denom, X, nX, ef->denomWarmup, denom);
 }
 
 
-/* Return the bandwidths of the filters.
+/* Return the bandwidths of the filters in ef.
  */
-void ermaFiltGetBandwidths(float *pNumerBW, float *pDenomBW)
+void ermaFiltGetBandwidths(ERMAFILT *ef, float *pNumerBW, float *pDenomBW)
 {
-    *pNumerBW = numerFilter.passband[1] - numerFilter.passband[0];
-    *pDenomBW = denomFilter.passband[1] - denomFilter.passband[0];
+    *pNumerBW = ef->numer.passband[1] - ef->numer.passband[0];
+    *pDenomBW = ef->denom.passband[1] - ef->denom.passband[0];
 }
@@ -1,15 +1,26 @@
 #ifndef _ERMAFILT_H_
 #define _ERMAFILT_H_
 
-extern IIRFILTER numerFilter, denomFilter;
+/* ERMAFILT has the numerator and denominator filters used by one detector
+ * profile, along with their warmup vectors. Each profile needs its own since
+ * the warmup carries the filter state from one call to the next.
+ */
+typedef struct {
+    IIRFILTER numer, denom;		/* the filters */
+    float *numerWarmup, *denomWarmup;	/* their warmup vectors, length 2n */
+} ERMAFILT;
 
-void ermaFiltPrep();
+void ermaFiltPrep(ERMAPARAMS *ep);
+void ermaFiltInit(ERMAFILT *ef, ERMAPARAMS *ep);
+void ermaFiltResetDownsample(void);
+void ermaFiltReset(ERMAFILT *ef);
 void ermaDownsample(float *X,  int32 nX,		/* in */
 		    int32 decim,			/* in */
 		    float *Y, int32 *nY,		/* out */
 		    float inSRate, float *outSRate);	/* in, out */
-void ermaNumerDenomFilt(float *X, int32 nX,		/* in */
+void ermaNumerDenomFilt(ERMAFILT *ef, float origSRate,	/* in & out, in */
+			float *X, int32 nX,		/* in */
 			float *numer, float *denom);	/* out */
-void ermaFiltGetBandwidths(float *pNumerBW, float *pDenomBW);
+void ermaFiltGetBandwidths(ERMAFILT *ef, float *pNumerBW, float *pDenomBW);
 
 #endif    /* _ERMAFILT_H_ */
@@ -3,7 +3,15 @@
 
 
 /* Forward declarations */
-float percentileAux(float *x, size_t xLen, size_t pos);
+static float selectAux(float *x, size_t xLen, size_t pos, uint64 *rngState);
+
+/* percentile() uses percentileRadix for arrays at least this long. It's
+ * faster from a few hundred elements up; see the benchmark at the bottom. */
+#define PCT_RADIX_MIN	1000
+
+/* selectAux switches to median-of-medians pivots after this many times the
+ * array length in work; random pivots average about 3.4 times. */
+#define PCT_MAX_WORK	8
 
 
 
@@ -149,6 +157,135 @@ int32 findInList(char *str, char **strlist)
 }
 
 
+/* Prepare a new, empty STRSET for use.
+ */
+void initSTRSET(STRSET *s)
+{
+    s->slot = NULL;
+    s->nSlot = 0;
+    s->n = 0;
+}
+
+
+/* Return the slot in s where str, whose hash is h, is, or the empty slot where
+ * it would go. The table is never more than half full, so there's always an
+ * empty slot.
+ */
+static size_t strSetFind(STRSET *s, char *str, uint32 h)
+{
+    size_t mask = s->nSlot - 1;
+    size_t i = h & mask;
+    while (s->slot[i].str != NULL &&
+	   (s->slot[i].hash != h || strcmp(s->slot[i].str, str)))
+	i = (i + 1) & mask;
+    return i;
+}
+
+
+/* Make the hash table in s big enough to hold n strings without growing.
+ */
+void strSetReserve(STRSET *s, size_t n)
+{
+    size_t nSlot = 64;
+    while (nSlot < 2 * n)
+	nSlot *= 2;
+    if (nSlot <= s->nSlot)
+	return;
+
+    STRSET bigger = { calloc(nSlot, sizeof(STRSETSLOT)), nSlot, s->n };
+    if (bigger.slot == NULL)
+	exit(ERMA_NO_MEMORY_STRSET);
+    for (size_t i = 0; i < s->nSlot; i++) {
+	STRSETSLOT *sl = &s->slot[i];
+	if (sl->str != NULL)
+	    bigger.slot[strSetFind(&bigger, sl->str, sl->hash)] = *sl;
+    }
+    free(s->slot);
+    *s = bigger;
+}
+
+
+/* Add str to the set s, if it's not there already. It's the pointer str that
+ * goes in the set, not a copy of the string. The hash table is doubled in size
+ * when it gets half full.
+ */
+void strSetAdd(STRSET *s, char *str)
+{
+    if (2 * (s->n + 1) > s->nSlot)
+	strSetReserve(s, MAX(s->n + 1, s->nSlot));
+    uint32 h = fnv1a(str, strlen(str));
+    size_t i = strSetFind(s, str, h);
+    if (s->slot[i].str == NULL) {
+	s->slot[i].str = str;
+	s->slot[i].hash = h;
+	s->n++;
+    }
+}
+
+
+/* Return 1 if str is in the set s, 0 if not.
+ */
+int strSetHas(STRSET *s, char *str)
+{
+    return s->n > 0 &&
+	s->slot[strSetFind(s, str, fnv1a(str, strlen(str)))].str != NULL;
+}
+
+
+/* Split buf, a '\0'-terminated string, into lines and add each one that's not
+ * empty to s. buf is altered: the line ends (\n or \r\n) are overwritten with
+ * '\0', and the lines in s point into buf, so it has to be kept.
+ */
+void strSetAddLines(STRSET *s, char *buf)
+{
+    size_t nLines = 1;
+    for (char *p = buf; (p = strchr(p, '\n')) != NULL; p++)
+	nLines++;
+    strSetReserve(s, s->n + nLines);
+
+    char *ln = buf;
+    while (*ln != '\0') {
+	char *end = strchr(ln, '\n');
+	char *next = (end != NULL) ? end + 1 : ln + strlen(ln);
+	if (end == NULL)
+	    end = next;
+	if (end > ln && end[-1] == '\r')
+	    end--;
+	*end = '\0';
+	if (end > ln)
+	    strSetAdd(s, ln);
+	ln = next;
+    }
+}
+
+
+/* Read all of a file into a new malloc'ed buffer, with a '\0' put on the end,
+ * and return it. The length (without the '\0') goes in *pLen if pLen isn't
+ * NULL. Returns NULL if the file can't be read.
+ */
+char *readWholeFile(char *filename, size_t *pLen)
+{
+    FILE *fp = fopen(filename, "rb");
+    struct stat st;
+    if (fp == NULL || fstat(fileno(fp), &st) != 0) {
+	if (fp != NULL)
+	    fclose(fp);
+	return NULL;
+    }
+    char *buf = malloc(st.st_size + 1);
+    size_t n = (buf == NULL) ? 0 : fread(buf, 1, st.st_size, fp);
+    fclose(fp);
+    if (buf == NULL || n != (size_t)st.st_size) {
+	free(buf);
+	return NULL;
+    }
+    buf[n] = '\0';
+    if (pLen != NULL)
+	*pLen = n;
+    return buf;
+}
+
+
 /* Return non-zero if a given directory exists, 0 if not.
  */
 int dirExists(char *dirPath)
@@ -347,6 +484,63 @@ char *timeStrD(char *buf, double tD)
 }
 
 
+/* Put ",<s>" at p, with s (in seconds) to 3 places, and return the end. This
+ * gives just what ",%.3lf" does, but makes the digits with integer arithmetic,
+ * which is a lot faster than printf's float formatting. Only a value within a
+ * hair of halfway between two milliseconds depends on exactly how s * 1000
+ * rounds, so those (and negative or huge ones, which shouldn't happen) are
+ * left to sprintf.
+ */
+char *putMillis(char *p, double s)
+{
+    double msD = s * 1000, whole = floor(msD);
+    if (!(s >= 0 && s < 1e6) || fabs(msD - whole - 0.5) < 1e-6)
+	return p + sprintf(p, ",%.3lf", s);
+
+    int64 ms = (int64)whole + (msD - whole > 0.5);
+    int64 sec = ms / 1000;
+    int32 frac = ms % 1000;
+    char digits[24];
+    int32 n = 0;
+    do {
+	digits[n++] = '0' + sec % 10;
+	sec /= 10;
+    } while (sec > 0);
+    *p++ = ',';
+    while (n > 0)
+	*p++ = digits[--n];
+    *p++ = '.';
+    *p++ = '0' + frac / 100;
+    *p++ = '0' + frac / 10 % 10;
+    *p++ = '0' + frac % 10;
+    return p;
+}
+
+
+/* Return the FNV-1a hash of the n bytes at p. It's used as a checksum on
+ * things written to files, to tell if they got written completely.
+ */
+uint32 fnv1a(void *p, size_t n)
+{
+    uint32 h = 2166136261u;
+    for (size_t i = 0; i < n; i++)
+	h = (h ^ ((uint8_t *)p)[i]) * 16777619u;
+    return h;
+}
+
+
+/* Return the current time in seconds from some arbitrary starting point. The
+ * clock is monotonic, so this is good for timing how long things take.
+ */
+double nowSec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+
 /* Return the value in array x, WHICH GETS REARRANGED DURING A CALL, that is the
  * pct'th-percentile smallest value. pct is between 0 and 1 inclusive; pct=0
  * returns the smallest value in x, pct=1 returns the largest, and pct=0.5
@@ -357,81 +551,191 @@ char *timeStrD(char *buf, double tD)
  * pct=0.37, there is no element of x that's at exactly the right position, so
  * the value returned is as if pct=0.4. Also, yes, percentiles are from 0 to 100
  * but here they're 0 to 1.
+ *
+ * Long arrays are done with percentileRadix and short ones with percentileR.
+ * Either way, the answer doesn't depend on the random numbers used, only how
+ * long it takes to get it. This is not thread-safe; use percentileR for that.
  */
 float percentile(float *x, size_t xLen, float pct)	//x[] GETS ALTERED!!!
 {
-    return percentileAux(x, xLen, (size_t)round((xLen - 1) * pct));
+    static uint64 rngState = 1;
+
+    if (xLen >= PCT_RADIX_MIN)
+	return percentileRadix(x, xLen, pct);
+    return percentileR(x, xLen, pct, &rngState);
+}
+
+
+/* Same as percentile(), but the random numbers for choosing pivots come from
+ * *rngState, which the caller owns, so it's safe to use from several threads at
+ * once as long as each has its own rngState. Start rngState with any value.
+ * x[] GETS ALTERED!!!
+ */
+float percentileR(float *x, size_t xLen, float pct, uint64 *rngState)
+{
+    if (xLen == 0)
+	return 0.0;
+    return selectAux(x, xLen, (size_t)round((xLen - 1) * pct), rngState);
+}
+
+
+/* Return a random number from 0 to n-1, using and updating *state. This is the
+ * xorshift64* generator; it only needs the state to be non-zero.
+ */
+static size_t randBelow(uint64 *state, size_t n)
+{
+    uint64 s = *state ? *state : 0x9e3779b97f4a7c15ULL;
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    *state = s;
+    uint32 r = (s * 0x2545f4914f6cdd1dULL) >> 32;
+    return (size_t)(((uint64)r * n) >> 32);
+}
+
+
+/* Rearrange x[0..n-1] into three parts: values < pivot in x[0..*pLo-1], values
+ * equal to pivot in x[*pLo..*pHi-1], and values > pivot in x[*pHi..n-1]. Since
+ * values equal to the pivot are set aside, lots of duplicate values don't slow
+ * down selectAux the way they would with a two-way split.
+ */
+static void partition3(float *x, size_t n, float pivot, size_t *pLo, size_t *pHi)
+{
+    size_t lo = 0, i = 0, hi = n;
+
+    while (i < hi) {
+	if (x[i] < pivot) {
+	    SWAP(x[lo], x[i]);
+	    lo++, i++;		//do NOT do this in the SWAP macro!
+	} else if (x[i] > pivot) {
+	    hi--;
+	    SWAP(x[i], x[hi]);
+	} else
+	    i++;
+    }
+    *pLo = lo;
+    *pHi = hi;
+}
+
+
+/* Return a pivot that's guaranteed to have at least 3/10 of x on each side of
+ * it: the median of the medians of groups of 5. Rearranges x.
+ */
+static float medianOfMedians(float *x, size_t n)
+{
+    size_t nMed = 0;
+
+    for (size_t i = 0; i < n; i += 5) {
+	size_t m = MIN(5, n - i);
+	for (size_t a = i + 1; a < i + m; a++)		//insertion sort
+	    for (size_t b = a; b > i && x[b] < x[b-1]; b--)
+		SWAP(x[b], x[b-1]);
+	SWAP(x[nMed], x[i + m/2]);	//collect the medians at the front
+	nMed++;
+    }
+    return selectAux(x, nMed, nMed / 2, NULL);
 }
 
 
 /* Return the element of x that is the pos'th smallest. x[] GETS ALTERED!!!
  *
- * Works by randomly choosing a pivot value, re-arranging x into a set of values
- * <= the pivot and a set > the pivot, and effectively recursing on whichever
- * set is appropriate.
+ * This is introselect: it works like quickselect, randomly choosing a pivot
+ * value, splitting x into values below, equal to, and above the pivot, and
+ * carrying on with whichever part has the pos'th value. Random pivots are fast
+ * on average, but an unlucky run of them could take O(n^2) time, so if the
+ * total work gets to be more than PCT_MAX_WORK times the length of x, the
+ * pivots switch to the slower but sure median of medians. That keeps the worst
+ * case O(n). If rngState is NULL, median of medians is used throughout.
  *
- * This is naturally a recursive function but it's iterative here because I'll
- * probably forget to turn on -O2 optimization in gcc to get tail recursion and
- * I don't want the stack to overflow or things to take too long.
+ * It's iterative rather than recursive (except via medianOfMedians) so the
+ * stack can't overflow.
  */
-float percentileAux(float *x, size_t xLen, size_t pos)
+static float selectAux(float *x, size_t xLen, size_t pos, uint64 *rngState)
 {
-    //This scaled value is used to get a uniform random number from 0..xLen-1.
-    float scale = 1.0 / (float)(1U<<31);
+    size_t work = 0, maxWork = PCT_MAX_WORK * xLen;
+
+    while (xLen > 1) {
+	float pivot;
+	if (rngState != NULL && work < maxWork)
+	    pivot = x[randBelow(rngState, xLen)];
+	else
+	    pivot = medianOfMedians(x, xLen);
+	work += xLen;
+
+	size_t lo, hi;
+	partition3(x, xLen, pivot, &lo, &hi);
+	if (pos < lo)
+	    xLen = lo;			//it's in the < part
+	else if (pos >= hi) {
+	    x    += hi;			//it's in the > part
+	    xLen -= hi;
+	    pos  -= hi;
+	} else
+	    return pivot;		//it's in the == part
+    }
+    return x[0];
+}
 
-    while (1) {
-	if (xLen <= 2) {	//handle special cases: length 1 or 2
-	    if (xLen == 2)
-		if (x[1] < x[0])
-		    SWAP(x[0], x[1]);
-	    return x[pos];
-	}
-	
-	//Rearrange x so that x[0..i] <= pivot and x[i+1..end] > pivot.
-	size_t ix = (size_t)floor(xLen * (float)lrand48() * scale);
-	if (ix >= xLen) ix = xLen - 1;	//just in case
-	float pivot = x[ix];
-	size_t i = 0, j = xLen-1;
-	int diff = 0;		//are any values different from pivot?
-	while (i < j) {
-	    while (x[i] <= pivot && i < j) {
-		if (x[i] != pivot) diff=1;
-		i++;
-	    }
-	    if (x[i] != pivot) diff=1;
-	    while (x[j] > pivot && j > i) {
-		if (x[j] != pivot) diff=1;
-		j--;
-	    }
-	    if (x[j] != pivot) diff=1;
-	    if (i < j-1) {
-		SWAP(x[i], x[j]);
-		i++, j--;	//do NOT do this in the SWAP macro!
-	    } else if (i == j-1) {
-		SWAP(x[i], x[j]);
-		break;
-	    } else {		//else i==j, as they can't move past each other
-		break;
-	    }
-	}
-	if (x[i] > pivot) {
-	    diff = 1;
-	    i--;
-	}
-	if (!diff && x[i] == pivot)	//handle case of all identical values
-	    return x[i];
 
-	//At this point, x[0 .. i] <= pivot and x[i+1 .. end] > pivot.
-	if (pos > i) {
-	    //Desired value is in x[i+1 .. end].
-	    x    += i + 1;
-	    xLen -= i + 1;
-	    pos  -= i + 1;
+/* Map a float to an unsigned int such that the ints sort in the same order as
+ * the floats (for anything but NaNs), and back again.
+ */
+static uint32 floatToKey(float f)
+{
+    uint32 u;
+    memcpy(&u, &f, sizeof(u));
+    return (u & 0x80000000) ? ~u : (u | 0x80000000);
+}
+
+static float keyToFloat(uint32 k)
+{
+    uint32 u = (k & 0x80000000) ? (k & 0x7fffffff) : ~k;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+
+/* Same as percentile(), but done by a radix select that takes O(n) time no
+ * matter what the data are, and does NOT alter x. Each float is turned into a
+ * 32-bit sort key; then each of three passes through x makes a histogram of
+ * the next 11 (or 10) bits of the keys that match the bits found so far, and
+ * the histogram says what those next bits of the answer's key are. This beats
+ * selectAux on large arrays; see the benchmark at the bottom of this file.
+ */
+float percentileRadix(float *x, size_t xLen, float pct)
+{
+    static const int shifts[3] = { 21, 10, 0 };	//bits 31-21, 20-10, 9-0
+    size_t hist[1 << 11];
+
+    if (xLen == 0)
+	return 0.0;
+    size_t pos = (size_t)round((xLen - 1) * pct);
+    uint32 prefix = 0;		//bits of the answer's key found so far
+
+    for (int p = 0; p < 3; p++) {
+	int shift = shifts[p];
+	int nBits = (p == 0) ? 11 : shifts[p-1] - shift;
+	uint32 mask = (1U << nBits) - 1;
+	memset(hist, 0, (mask + 1) * sizeof(hist[0]));
+	if (p == 0) {
+	    for (size_t i = 0; i < xLen; i++)
+		hist[floatToKey(x[i]) >> shift]++;
 	} else {
-	    //Desired value is in x[0 .. i].
-	    xLen = i + 1;
+	    int hiShift = shifts[p-1];
+	    for (size_t i = 0; i < xLen; i++) {
+		uint32 k = floatToKey(x[i]);
+		if ((k >> hiShift) == prefix)
+		    hist[(k >> shift) & mask]++;
+	    }
 	}
+	//Find the bin holding the pos'th value among those that matched.
+	uint32 b = 0;
+	while (pos >= hist[b])
+	    pos -= hist[b++];
+	prefix = (prefix << nBits) | b;
     }
+    return keyToFloat(prefix);
 }
 
 
@@ -627,3 +931,227 @@ int main() {
 }
 #endif
 /**********************************************************************/
+
+
+/* This benchmarks the percentile routines on arrays like quietTimes.c's
+ * avgPower: block powers that are roughly log-normal, with stretches of loud
+ * glider-motor noise. The old lrand48() quickselect is included for comparison.
+ * It also times an array that's nearly all one value, which is so slow for the
+ * old quickselect that only the short length is tried.
+ * Compile with
+ *
+ *		cc -O3 -DGOODIES_MAIN -include erma.h ermaGoodies.c -lm
+ */
+#ifdef GOODIES_MAIN
+static float oldSelect(float *x, size_t xLen, size_t pos)
+{
+    //This scaled value is used to get a uniform random number from 0..xLen-1.
+    float scale = 1.0 / (float)(1U<<31);
+
+    while (1) {
+	if (xLen <= 2) {	//handle special cases: length 1 or 2
+	    if (xLen == 2)
+		if (x[1] < x[0])
+		    SWAP(x[0], x[1]);
+	    return x[pos];
+	}
+	
+	//Rearrange x so that x[0..i] <= pivot and x[i+1..end] > pivot.
+	size_t ix = (size_t)floor(xLen * (float)lrand48() * scale);
+	if (ix >= xLen) ix = xLen - 1;	//just in case
+	float pivot = x[ix];
+	size_t i = 0, j = xLen-1;
+	int diff = 0;		//are any values different from pivot?
+	while (i < j) {
+	    while (x[i] <= pivot && i < j) {
+		if (x[i] != pivot) diff=1;
+		i++;
+	    }
+	    if (x[i] != pivot) diff=1;
+	    while (x[j] > pivot && j > i) {
+		if (x[j] != pivot) diff=1;
+		j--;
+	    }
+	    if (x[j] != pivot) diff=1;
+	    if (i < j-1) {
+		SWAP(x[i], x[j]);
+		i++, j--;	//do NOT do this in the SWAP macro!
+	    } else if (i == j-1) {
+		SWAP(x[i], x[j]);
+		break;
+	    } else {		//else i==j, as they can't move past each other
+		break;
+	    }
+	}
+	if (x[i] > pivot) {
+	    diff = 1;
+	    i--;
+	}
+	if (!diff && x[i] == pivot)	//handle case of all identical values
+	    return x[i];
+
+	//At this point, x[0 .. i] <= pivot and x[i+1 .. end] > pivot.
+	if (pos > i) {
+	    //Desired value is in x[i+1 .. end].
+	    x    += i + 1;
+	    xLen -= i + 1;
+	    pos  -= i + 1;
+	} else {
+	    //Desired value is in x[0 .. i].
+	    xLen = i + 1;
+	}
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    size_t lens[] = { 6000, 60000, 600000 };
+    uint64 rngState = 1;
+
+    srand48(1);
+    for (int dup = 0; dup <= 1; dup++) {
+	for (int i = 0; i < (dup ? 1 : NUM_OF(lens)); i++) {
+	    size_t n = lens[i];
+	    int32 nRep = dup ? 5 : 6000000 / n;
+	    float *x = malloc(n * sizeof(float)), *y = malloc(n * sizeof(float));
+	    for (size_t j = 0; j < n; j++) {
+		double g = sqrt(-2 * log(drand48())) * cos(2 * M_PI * drand48());
+		x[j] = exp(g) * ((j / 1000) % 5 == 0 ? 100 : 1);
+		if (dup && drand48() < 0.99)
+		    x[j] = 7;
+	    }
+	    double sec[3] = { 0, 0, 0 };
+	    float val[3];
+	    for (int32 r = 0; r < nRep; r++) {
+		for (int a = 0; a < 3; a++) {
+		    memcpy(y, x, n * sizeof(float));
+		    double t0 = nowSec();
+		    size_t pos = (size_t)round((n - 1) * 0.1);
+		    val[a] = (a == 0) ? oldSelect(y, n, pos)
+			:    (a == 1) ? percentileR(y, n, 0.1, &rngState)
+			:               percentileRadix(y, n, 0.1);
+		    sec[a] += nowSec() - t0;
+		}
+	    }
+	    printf("%s n %7ld: quickselect %7.1f us, introselect %7.1f us, "
+		   "radix %7.1f us%s\n", dup ? "dups  " : "avgPow", n,
+		   sec[0] / nRep * 1e6, sec[1] / nRep * 1e6, sec[2] / nRep * 1e6,
+		   (val[0] == val[1] && val[1] == val[2]) ? "" : "  MISMATCH!");
+	    free(x);
+	    free(y);
+	}
+    }
+    return 0;
+}
+#endif	/* GOODIES_MAIN */
+/**********************************************************************/
+
+
+/* This benchmarks the startup work of looking up the input files in the list
+ * of files already processed (see readFilesProcessed and getNewFiles in
+ * ErmaMain.c), with lists 10k, 100k, and 1M files long. The old way -- a
+ * getline for each line of files_processed, then findInList for each file --
+ * is included for comparison. Its lookups take so long with the longer lists
+ * that only some of them are timed and the total is estimated from those.
+ * Compile with
+ *
+ *		cc -O3 -DSTRSET_MAIN -include erma.h ermaGoodies.c -lm
+ */
+#ifdef STRSET_MAIN
+static char **oldReadFilesProcessed(char *filename)
+{
+    char **filelist = NULL;
+    size_t filelistSize = 0;
+    int32 nFiles = 0;
+    FILE *fp = fopen(filename, "r");
+    while (1) {
+	BUFGROW(filelist, nFiles + 1, ERMA_NO_MEMORY_FILELIST);
+	filelist[nFiles] = NULL;
+	if (fp == NULL)
+	    return filelist;
+	char *ln = NULL;
+	size_t lnSize = 0;
+	if (getline(&ln, &lnSize, fp) < 0) {
+	    fclose(fp);
+	    return filelist;
+	}
+	if (ln[strlen(ln)-1] == '\r' || ln[strlen(ln)-1] == '\n')
+	    ln[strlen(ln)-1] = '\0';
+	filelist[nFiles++] = ln;
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int32 lens[] = { 10000, 100000, 1000000 };
+    int32 nNew = 100;		//files in the directory not processed yet
+    int32 nTimed = 2000;	//old-way lookups timed, for the estimate
+    char *path = "/tmp/strset_files_processed.txt";
+
+    srand48(1);
+    for (int i = 0; i < NUM_OF(lens); i++) {
+	//Make a files_processed with n names like WISPR's, and the list of all
+	//the files in the directory: those plus nNew more, in random order.
+	int32 n = lens[i], nDir = n + nNew;
+	char **dirList = malloc(nDir * sizeof(char *));
+	FILE *fp = fopen(path, "w");
+	for (int32 j = 0; j < nDir; j++) {
+	    char name[64];
+	    snprintf(name, sizeof(name), "WISPR_%06d_%06d.dat",
+		     170610 + j / 86400, j % 86400);
+	    if (j < n)
+		fprintf(fp, "%s\n", name);
+	    dirList[j] = strsave(name);
+	}
+	fclose(fp);
+	for (int32 j = nDir - 1; j > 0; j--) {
+	    int32 k = lrand48() % (j + 1);
+	    SWAP(dirList[j], dirList[k]);
+	}
+
+	//Old way.
+	double t0 = nowSec();
+	char **list = oldReadFilesProcessed(path);
+	double tOldRead = nowSec() - t0;
+	int32 nOldNew = 0;
+	t0 = nowSec();
+	for (int32 j = 0; j < MIN(nTimed, nDir); j++)
+	    nOldNew += (findInList(dirList[j], list) < 0);
+	double tOldFind = (nowSec() - t0) * nDir / MIN(nTimed, nDir);
+
+	//New way.
+	t0 = nowSec();
+	STRSET set;
+	initSTRSET(&set);
+	char *buf = readWholeFile(path, NULL);
+	strSetAddLines(&set, buf);
+	double tNewRead = nowSec() - t0;
+	int32 nNewNew = 0;
+	t0 = nowSec();
+	for (int32 j = 0; j < nDir; j++)
+	    nNewNew += !strSetHas(&set, dirList[j]);
+	double tNewFind = nowSec() - t0;
+
+	printf("n %7d: old read %8.4f s, lookups %9.3f s%s; "
+	       "new read %7.4f s, lookups %7.4f s; %s\n", n,
+	       tOldRead, tOldFind, nDir > nTimed ? " (est.)" : "",
+	       tNewRead, tNewFind,
+	       (nNewNew == nNew && set.n == n && nOldNew <= nNew)
+	       ? "ok" : "MISMATCH!");
+
+	for (int32 j = 0; list[j] != NULL; j++)
+	    free(list[j]);
+	free(list);
+	free(buf);
+	free(set.slot);
+	for (int32 j = 0; j < nDir; j++)
+	    free(dirList[j]);
+	free(dirList);
+    }
+    unlink(path);
+    return 0;
+}
+#endif	/* STRSET_MAIN */
+/**********************************************************************/
@@ -5,6 +5,22 @@
 /*#include <stdio.h>	*//* for FILE */
 /*#include <stdint.h>	*//* for int32_t */
 
+/* A set of strings, kept in a hash table with open addressing. The set holds
+ * pointers to the strings, not copies, so they must stay around as long as the
+ * set is used. Each slot has the string's hash too, so a probe only looks at
+ * the string itself when the hashes match. See strSetAdd in ermaGoodies.c.
+ */
+typedef struct {
+    char *str;		//NULL for an empty slot
+    uint32 hash;	//fnv1a of str
+} STRSETSLOT;
+
+typedef struct {
+    STRSETSLOT *slot;	//the hash table
+    size_t nSlot;	//size of slot, a power of 2
+    size_t n;		//number of strings in the set
+} STRSET;
+
 int bufgrow(void *buf1, size_t *byteSize, size_t newByteSize, void **auxPtr);
 char *strsave(char *str);
 char *pathFile(char *pathname);
@@ -12,6 +28,12 @@ char *pathExt(char *pathname);
 char *pathRoot(char *buf, char *pathname);
 char *pathDir(char *buf, char *pathname);
 int32 findInList(char *str, char **strlist);
+void initSTRSET(STRSET *s);
+void strSetReserve(STRSET *s, size_t n);
+void strSetAdd(STRSET *s, char *str);
+int strSetHas(STRSET *s, char *str);
+void strSetAddLines(STRSET *s, char *buf);
+char *readWholeFile(char *filename, size_t *pLen);
 int dirExists(char *dirPath);
 float meanF(float *x, int32 n);
 int32 maxIx(float *x, int32 nX, float *pMaxVal);
@@ -24,7 +46,12 @@ size_t readFloatArray(float **pX, size_t *pXSize, size_t maxN, char *filename);
 time_t my_timegm(struct tm *tm);
 char *timeStrE(char *buf, time_t tE);
 char *timeStrD(char *buf, double tD);
+char *putMillis(char *p, double s);
+double nowSec(void);
+uint32 fnv1a(void *p, size_t n);
 float percentile(float *x, size_t xLen, float pct);	//x[] GETS ALTERED!!!
+float percentileR(float *x, size_t xLen, float pct, uint64 *rngState);
+float percentileRadix(float *x, size_t xLen, float pct);
 void int16ToFloat(float *dst, int16 *src, size_t n);
 
 
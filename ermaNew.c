@@ -7,13 +7,7 @@ static void calcAverageRatio(float *num, float *den, int32 nNum,
 			     int32 avgSam, float *ratio, int32 *pNRatio,
 			     float *numAvg, float *denAvg);
 int32 peakNear(float *x, int32 nX, int32 ix, int32 nbdSam);
-void findClicks(float *x, int32 nX, float segT0, float *ratio, int32 nRatio,
-		float sRate, ERMAPARAMS *ep, int32 delaySam, float bwNumer,
-		FILECLICKS *fc, float *seg, size_t nSeg, float segSRate);
-void addSpec(CLICKSPEC cs, float t, float *seg, size_t nSeg,
-	     float sRate, size_t nSpecSams, float *win);
 void writeFILECLICKS(FILECLICKS *fc, char *filename);
-void writeALLCLICKS(ALLCLICKS *ac, char *filename);
 
 
 
@@ -23,6 +17,12 @@ void initFILECLICKS(FILECLICKS *fc)
 {
     fc->timeS = NULL;		/* times of clicks in file, s */
     fc->timeSSize = 0;		/* for bufgrow */
+    fc->spec = NULL;		/* spectrum of each click */
+    fc->specSize = 0;		/* for bufgrow */
+    fc->ratioPk = NULL;		/* ratio at each click's peak */
+    fc->ratioPkSize = 0;	/* for bufgrow */
+    fc->numerPk = NULL;		/* numerator power at click's peak */
+    fc->numerPkSize = 0;	/* for bufgrow */
     fc->n = 0;			/* number of clicks found this file */
 }
 
@@ -36,124 +36,414 @@ void resetFILECLICKS(FILECLICKS *fc)
 }
 
 
-void initALLCLICKS(ALLCLICKS *ac)
+/* Prepare a new ERMASTATE for use.
+ */
+void initERMASTATE(ERMASTATE *es)
 {
-    ac->timeD = NULL;
-    ac->timeDSize = 0;
-    ac->n = 0;
+    es->tail = NULL;
+    es->tailSize = 0;		/* for bufgrow */
+    resetERMASTATE(es);
 }
 
 
-/* Iterate through the quiet time segments in qt, running ERMA on each segment.
- * Results are in fc, as times in seconds in snd at which a click occurred.
+/* Prepare an ERMASTATE for the start of a new signal.
+ */
+void resetERMASTATE(ERMASTATE *es)
+{
+    es->decayMean = -1;		/* expDecay warms up afresh */
+    es->decayIgnore = 0;
+    es->fresh = 1;
+    es->nTail = 0;		/* nothing carried into the signals */
+}
+
+
+/* The last nSegTail samples of the segment ermaNew last ran on (including any
+ * carried into it), for the click spectra near the start of the next one. */
+static float *segTail = NULL;
+static size_t segTailSize = 0;
+static int32 nSegTail = 0;
+
+/* Decide whether the quiet-time segment span of the file described by wi
+ * carries straight on from the last segment processed. Within a file, that
+ * means it starts at the sample where the last one ended. Across files (newFile
+ * is 1 for the first segment of a file), it means the last segment ran to the
+ * end of its file (give or take a partial noise block that quietTimes.c drops),
+ * this one starts at the start of its file, and the file times line up to
+ * within ep->contMaxGapS. If so, the downsampling filter and each of the nProf
+ * profiles' filter and expDecay states are left as they are, so the two
+ * segments are processed as one signal. If not, all that state is reset, and
+ * ermaSignals marks the start of the segment as warmup. Returns 1 if the state
+ * is carried over, 0 if it was reset. The ends of the last segment's signals
+ * (see ermaSignals and ermaNew) are carried over only within a file.
+ */
+int ermaContinue(WISPRINFO *wi, TIMESPAN_S *span, int newFile,
+		 ERMAPARAMS *ep, ERMAPROFILE *prof, int32 nProf)
+{
+    static int haveLast = 0;
+    static double lastEndE;		/* end time of the last file */
+    static int64 lastLeftSam;		/* samples after the last segment */
+    static int64 lastSam1;		/* where the last segment ended */
+    static float lastSRate;
+    int cont;
+
+    if (!haveLast)
+	cont = 0;
+    else if (!newFile)
+	cont = (span->sam0 == lastSam1);
+    else {
+	int64 blockLen = round(ep->ns_tBlockS * wi->sRate);
+	cont = (wi->sRate == lastSRate && span->sam0 == 0 &&
+		lastLeftSam < blockLen &&
+		fabs(wi->timeE - lastEndE) <= ep->contMaxGapS);
+    }
+    if (!cont)
+	ermaFiltResetDownsample();
+    if (!cont || newFile)
+	nSegTail = 0;
+    for (int32 p = 0; p < nProf; p++) {
+	if (!cont) {
+	    ermaFiltReset(&prof[p].filt);
+	    resetERMASTATE(&prof[p].state);
+	} else {
+	    prof[p].state.fresh = 0;
+	    if (newFile)
+		prof[p].state.nTail = 0;
+	}
+    }
+
+    haveLast = 1;
+    lastEndE = wi->timeE + wi->nSamp / wi->sRate;
+    lastLeftSam = wi->nSamp - span->sam1;
+    lastSam1 = span->sam1;
+    lastSRate = wi->sRate;
+    return cont;
+}
+
+
+/* Number of samples looked at by the energy gate, and how many of them it
+ * passed on to ERMA, for ermaGateGetStats. */
+static int64 gateNIn = 0, gateNPassed = 0;
+
+/* The energy gate: a cheap first pass that picks out the parts of a quiet-time
+ * span of snd that might have clicks in them, so the full ERMA chain is run
+ * only on those parts. The span is cut into windows of ep->gateWinS seconds,
+ * and the energy in each is estimated from every ep->gateDecim'th sample of
+ * x[j] - x[j-lag]. This difference is a crude bandpass filter, with a gain of
+ * 2 at ep->gateFreq (lag = sRate/2/gateFreq) and 0 at DC and twice gateFreq,
+ * so with gateFreq in the numerator band it favors clicks over low-frequency
+ * flow noise at a cost of one subtraction per sample used. Windows whose
+ * energy is over ep->gateThresh times the median for the span are passed,
+ * along with ep->gateMarginS s before them to warm up the filters and expDecay
+ * and a little after them for the ratio average and peak neighborhood. A
+ * smaller gateThresh is more conservative: it passes more and misses fewer
+ * clicks.
+ *
+ * The pieces to process are put in *pSub, a static buffer, and their number is
+ * returned. If the gate is off (gateThresh <= 0), the piece is the whole span.
+ */
+static int32 gateSpan(float *spanSnd, TIMESPAN_S *span, float sRate,
+		      ERMAPARAMS *ep, TIMESPAN_S **pSub)
+{
+    static TIMESPAN_S *sub = NULL;
+    static float *en = NULL, *enCopy = NULL;
+    static size_t subSize = 0, enSize = 0, enCopySize = 0;
+    int64 winLen = MAX(1, round(ep->gateWinS * sRate));
+    int64 nWin = (span->sam1 - span->sam0) / winLen;
+    int32 step = MAX(1, ep->gateDecim);
+    int32 lag = MAX(1, round(sRate / (2 * ep->gateFreq)));
+    int32 nSub = 0;
+
+    BUFGROW(sub, 1, ERMA_NO_MEMORY_GATE);
+    *pSub = sub;
+    gateNIn += span->sam1 - span->sam0;
+    if (ep->gateThresh <= 0 || nWin < 2) {
+	sub[0] = *span;
+	gateNPassed += span->sam1 - span->sam0;
+	return 1;
+    }
+
+    /* Get the energy of each window and the threshold. */
+    BUFGROW(en, nWin, ERMA_NO_MEMORY_GATE);
+    BUFGROW(enCopy, nWin, ERMA_NO_MEMORY_GATE);
+    for (int64 w = 0; w < nWin; w++) {
+	float *x = &spanSnd[w * winLen];
+	double sum = 0.0;
+	for (int64 j = lag; j < winLen; j += step) {
+	    float d = x[j] - x[j-lag];
+	    sum += d * d;
+	}
+	en[w] = sum;
+    }
+    memcpy(enCopy, en, nWin * sizeof(en[0]));
+    float thresh = percentile(enCopy, nWin, 0.5) * ep->gateThresh;
+
+    /* Collect the passed windows with their margins, merging any that overlap
+     * or touch. A piece that reaches the last whole window also gets the
+     * partial window at the end of the span. */
+    int64 mBefore = ceil(ep->gateMarginS / ep->gateWinS);
+    int64 mAfter = ceil((ep->avgT + ep->peakNbdT) / ep->gateWinS) + 1;
+    for (int64 w = 0; w < nWin; w++) {
+	if (en[w] <= thresh)
+	    continue;
+	int64 w0 = MAX(0, w - mBefore), w1 = MIN(nWin, w + 1 + mAfter);
+	int64 s0 = span->sam0 + w0 * winLen;
+	int64 s1 = (w1 == nWin) ? span->sam1 : span->sam0 + w1 * winLen;
+	if (nSub > 0 && s0 <= sub[nSub-1].sam1)
+	    sub[nSub-1].sam1 = s1;
+	else {
+	    BUFGROW(sub, nSub + 1, ERMA_NO_MEMORY_GATE);
+	    sub[nSub].sam0 = s0;
+	    sub[nSub++].sam1 = s1;
+	}
+    }
+    for (int32 i = 0; i < nSub; i++) {
+	sub[i].tS.t0 = sub[i].sam0 / sRate;
+	sub[i].tS.t1 = sub[i].sam1 / sRate;
+	gateNPassed += sub[i].sam1 - sub[i].sam0;
+    }
+    *pSub = sub;
+    return nSub;
+}
+
+
+/* Report how many samples the energy gate has looked at so far, and how many
+ * of those it passed on to ERMA.
+ */
+void ermaGateGetStats(int64 *pNIn, int64 *pNPassed)
+{
+    *pNIn = gateNIn;
+    *pNPassed = gateNPassed;
+}
+
+
+/* Iterate through the quiet time segments in qt, running ERMA on each segment
+ * (or on the parts of it that the energy gate passes) for each of the nProf
+ * detector profiles in prof. snd has the samples of just the segments, put
+ * end-to-end (see decodeQuietTimes). Results are in each profile's fileC, as
+ * times in seconds in the file at which a click occurred.
  */
 void ermaSegments(float *snd, WISPRINFO *wi, ERMAPARAMS *ep, QUIETTIMES *qt,
-		  FILECLICKS *fc)
+		  ERMAPROFILE *prof, int32 nProf)
+{
+    for (int32 p = 0; p < nProf; p++)
+	resetFILECLICKS(&prof[p].fileC);
+    ermaMoreSegments(snd, wi, ep, qt, 1, prof, nProf);
+}
+
+
+/* The same as ermaSegments, except that the clicks found are added to what's
+ * already in each profile's fileC. This is for when a file's quiet times come
+ * a few at a time (see onlineSegments in processFile.c); newFile is 1 if these
+ * are the first of the file's quiet times.
+ */
+void ermaMoreSegments(float *snd, WISPRINFO *wi, ERMAPARAMS *ep,
+		      QUIETTIMES *qt, int newFile, ERMAPROFILE *prof,
+		      int32 nProf)
 {
-    int i;
-    int32 i0, i1;
-
-    resetFILECLICKS(fc);
-    for (i = 0; i < qt->n; i++) {
-	i0 = qt->tSpan[i].sam0;
-	i1 = qt->tSpan[i].sam1;
-	ermaNew(&snd[i0], i1 - i0, qt->tSpan[i].tS.t0, wi->sRate, ep, fc);
+    size_t off = 0;		//where segment i starts in snd
+    for (int32 i = 0; i < qt->n; i++) {
+	TIMESPAN_S *span = &qt->tSpan[i], *sub;
+	float *spanSnd = &snd[off];
+	off += span->sam1 - span->sam0;
+	int32 nSub = gateSpan(spanSnd, span, wi->sRate, ep, &sub);
+	for (int32 j = 0; j < nSub; j++) {
+	    int64 i0 = sub[j].sam0, i1 = sub[j].sam1;
+	    ermaContinue(wi, &sub[j], newFile && i == 0 && j == 0, ep, prof,
+			 nProf);
+	    ermaNew(&spanSnd[i0 - span->sam0], i1 - i0, sub[j].tS.t0,
+		    wi->sRate, ep, prof, nProf);
+	}
     }
 }
 
 
-/* Run the ERMA process on a segment of snd for nSam samples. Results (click
- * detections) are left in fc.
+/* Run the ERMA process on a segment of snd for nSam samples. The segment is
+ * downsampled once, using the shared params in ep, and then each of the nProf
+ * profiles in prof runs its own detector on the result. Results (click
+ * detections) are left in each profile's fileC. If the segment carries on from
+ * the last one in the same file, the profiles' signals start with the end of
+ * the last segment's (see ermaSignals), so the samples of that are put in
+ * front of seg too, for the spectra of any clicks found there.
  */
 void ermaNew(float *seg, int32 nSeg, float segT0, float sRate, ERMAPARAMS *ep,
-	     FILECLICKS *fc)
+	     ERMAPROFILE *prof, int32 nProf)
 {
     static float *x = NULL;	/* the decimated signal */
     static size_t xSize = 0;
-    int32 nX, nRatio;
-    float bwNumer, bwDenom, newSRate;
+    static float *segBuf = NULL; /* seg with the carried samples in front */
+    static size_t segBufSize = 0;
+    int32 nX;
+    float newSRate;
 
     /* Decimate the signal. x ends up 1/ep->decim as long as seg, but during
      * filtering it needs to be as long as seg, so nSeg is used here. */
     BUFGROW(x, nSeg, ERMA_NO_MEMORY_DECIMBUF);
-    float origSRate = sRate;
     ermaDownsample(seg, nSeg, ep->decim, x, &nX, sRate, &newSRate);
-    sRate = newSRate;
+
+#ifdef DEBUG_SAVE_ARRAYS
+    writeFloatArray(seg, nSeg, "temp-x.flt");
+#endif
+
+    float *segC = seg;
+    size_t nSegC = nSegTail + nSeg;
+    if (nSegTail > 0) {
+	BUFGROW(segBuf, nSegC, ERMA_NO_MEMORY_DECIMBUF);
+	memcpy(segBuf, segTail, nSegTail * sizeof(segBuf[0]));
+	memcpy(&segBuf[nSegTail], seg, nSeg * sizeof(segBuf[0]));
+	segC = segBuf;
+    }
+
+    /* Run each profile's detector: compute the ERMA signals, then find the
+     * clicks in them. Results (click detections) are left in prof[p].fileC.
+     * The part of segC before sig's start is skipped. */
+    int32 decim = round(sRate / newSRate), nTailMax = 0;
+    for (int32 p = 0; p < nProf; p++) {
+	ERMASIGNALS sig;
+	int32 nT = prof[p].state.nTail;
+	size_t skip = MAX(0, nSegTail - (int64)nT * decim);
+	ermaSignals(x, nX, segT0, newSRate, sRate, &prof[p], &sig);
+	findClicks(&sig, &prof[p].ep, &prof[p].fileC, &segC[skip],
+		   nSegC - skip, sRate, &prof[p].state);
+	nTailMax = MAX(nTailMax, prof[p].state.nTail);
+    }
+
+    /* Keep the samples to go with the signals carried into the next one. */
+    nSegTail = MIN(nSegC, (size_t)nTailMax * decim);
+    BUFGROW(segTail, nSegTail, ERMA_NO_MEMORY_DECIMBUF);
+    memcpy(segTail, &segC[nSegC - nSegTail], nSegTail * sizeof(segC[0]));
+}
+
+
+/* Compute one profile's ERMA signals from x, a downsampled segment of nX
+ * samples at sample rate sRate that starts segT0 s into the file. origSRate is
+ * the sample rate before downsampling, which picks the default filters. The
+ * signals are left in *sig; its numer and ratio arrays are static buffers,
+ * good until the next call. The filters and expDecay carry on from the previous
+ * segment unless ermaContinue reset them, in which case the first ep->warmupS
+ * seconds are marked as warmup in sig.
+ *
+ * findClicks can't look for clicks in the last avgSam-1 samples of the signals,
+ * where the ratio isn't complete, and near the start it can't look back the
+ * delaySam + nbdSam samples it needs. So that a boundary between two segments
+ * of a file that carry straight on from each other (like the pieces of a quiet
+ * time from a QUIETSTREAM) doesn't lose clicks, the last avgSam-1 + delaySam +
+ * nbdSam samples of the signals are kept in prof->state and put in front of
+ * the next segment's, and findClicks carries on where it stopped. Then sig
+ * starts that much before segT0.
+ */
+void ermaSignals(float *x, int32 nX, float segT0, float sRate, float origSRate,
+		 ERMAPROFILE *prof, ERMASIGNALS *sig)
+{
+    ERMAPARAMS *ep = &prof->ep;
+    ERMASTATE *es = &prof->state;
+    int32 nRatio;
+    float bwNumer, bwDenom;
+    int32 nT = es->nTail;		//samples carried from the last segment
+    int32 nC = nT + nX;			//length of the signals with them
 
     /* Do the ERMA filtering: calculate the numerator signal, the denominator
-     * signal, and (eventually) their power ratio. */
+     * signal, and (eventually) their power ratio. x isn't changed, as other
+     * profiles use it too. */
     static float *numer = NULL, *denom = NULL, *ratio = NULL;
     static size_t numerSize = 0, denomSize = 0, ratioSize = 0;
-    BUFGROW(numer, nX, ERMA_NO_MEMORY_NUMER_DENOM);
-    BUFGROW(denom, nX, ERMA_NO_MEMORY_NUMER_DENOM);
-    BUFGROW(ratio, nX, ERMA_NO_MEMORY_NUMER_DENOM);
-    ermaNumerDenomFilt(x, nX, numer, denom); //numer, denom same length as x
+    BUFGROW(numer, nC, ERMA_NO_MEMORY_NUMER_DENOM);
+    BUFGROW(denom, nC, ERMA_NO_MEMORY_NUMER_DENOM);
+    BUFGROW(ratio, nC, ERMA_NO_MEMORY_NUMER_DENOM);
+    //numer, denom same length as x, after the carried samples
+    ermaNumerDenomFilt(&prof->filt, origSRate, x, nX, &numer[nT], &denom[nT]);
 
 #ifdef DEBUG_SAVE_ARRAYS
     printf("ermaNew: writing temp signal files\n");
-    writeFloatArray(seg, nSeg, "temp-x.flt");
     writeFloatArray(x, nX, "tempY-downSampled.flt");
     char fname[256];
     sprintf(fname, "tempY-downSampled.b%d", (long)round(sRate / 100));
     writeShortFromFloat(x, nX, fname);
-    writeFloatArray(numer, nX, "temp-numer.flt");
-    writeFloatArray(denom, nX, "temp-denom.flt");
+    writeFloatArray(&numer[nT], nX, "temp-numer.flt");
+    writeFloatArray(&denom[nT], nX, "temp-denom.flt");
 #endif
 
-    ermaFiltGetBandwidths(&bwNumer, &bwDenom);
+    ermaFiltGetBandwidths(&prof->filt, &bwNumer, &bwDenom);
     bwNumer /= 1000.0;		/* make Hz into kHz */
     bwDenom /= 1000.0;		/* make Hz into kHz */
     
-    int32 filtDelaySam = (numerFilter.n + 1) / 2;
+    int32 filtDelaySam = (prof->filt.numer.n + 1) / 2;
 /*    float filtDelayT = (float)filtDelaySam / sRate;*/
 
     /* Convert filtered signals to power per kHz of bandwidth, re-using numer
      * and denom for this (called powNumer and powDenom in * MATLAB). */
     float bwNumerInv = 1.0 / bwNumer;
     float bwDenomInv = 1.0 / bwDenom;
-    for (int32 i = 0; i < nX; i++) {
+    for (int32 i = nT; i < nC; i++) {
 	numer[i] = numer[i] * numer[i] * bwNumerInv;
 	denom[i] = denom[i] * denom[i] * bwDenomInv;
     }
-    /* Compute power ratio while power is in numer and denom. */
+    /* Put the carried power in front. tail has room for nKeep samples of
+     * numer power, then of denom power, then of normPowNumer. */
     float avgSam = round(ep->avgT * sRate);	// # samples to average over
+    //Delay from numer to ratio, i.e., numer[i] aligns with ratio[i - delaySam]
+    int32 delaySam = avgSam / 2;
+    int32 nKeep = avgSam - 1 + delaySam + round(ep->peakNbdT * sRate);
+    BUFGROW(es->tail, 3 * (size_t)nKeep, ERMA_NO_MEMORY_NUMER_DENOM);
+    float *tailNumer = es->tail, *tailDenom = &es->tail[nKeep];
+    float *tailNorm = &es->tail[2 * nKeep];
+    memcpy(numer, tailNumer, nT * sizeof(numer[0]));
+    memcpy(denom, tailDenom, nT * sizeof(denom[0]));
+
+    /* Compute power ratio while power is in numer and denom. */
     #if !ON_RPI
     static float *numAvg = NULL, *denAvg = NULL;
     static size_t numAvgSize = 0, denAvgSize = 0;
-    BUFGROW(numAvg, nX, ERMA_NO_MEMORY_NUMER_DENOM_AVG);
-    BUFGROW(denAvg, nX, ERMA_NO_MEMORY_NUMER_DENOM_AVG);
-    calcAverageRatio(numer, denom, nX, avgSam, ratio, &nRatio, numAvg, denAvg);
+    BUFGROW(numAvg, nC, ERMA_NO_MEMORY_NUMER_DENOM_AVG);
+    BUFGROW(denAvg, nC, ERMA_NO_MEMORY_NUMER_DENOM_AVG);
+    calcAverageRatio(numer, denom, nC, avgSam, ratio, &nRatio, numAvg, denAvg);
     #else
-    calcAverageRatio(numer, denom, nX, avgSam, ratio, &nRatio, NULL, NULL);
+    calcAverageRatio(numer, denom, nC, avgSam, ratio, &nRatio, NULL, NULL);
     #endif
-    //Delay from numer to ratio, i.e., numer[i] aligns with ratio[i - delaySam]
-    int32 delaySam = avgSam / 2;
 
-#ifdef DEBUG_SAVE_ARRAYS
+    /* Keep the end of the power for the next segment. */
+    int32 nNewT = MIN(nKeep, nC);
+    memcpy(tailNumer, &numer[nC - nNewT], nNewT * sizeof(numer[0]));
+    memcpy(tailDenom, &denom[nC - nNewT], nNewT * sizeof(denom[0]));
+
+#if defined(DEBUG_SAVE_ARRAYS) && !ON_RPI	//numAvg is made only off the Pi
     printf("ermaNew: writing temp files starting at %.5f s\n", segT0);
-    writeFloatArray(numer,  nX, "temp-numerPow.flt");
-    writeFloatArray(denom,  nX, "temp-denomPow.flt");
-    writeFloatArray(ratio,  nX, "temp-ratio.flt");
-    writeFloatArray(numAvg, nX-avgSam+1, "temp-numAvg.flt");
-    writeFloatArray(denAvg, nX-avgSam+1, "temp-denAvg.flt");
-    writeFloatArray(ratio,  nX, "temp-ratio.flt");
+    writeFloatArray(numer,  nC, "temp-numerPow.flt");
+    writeFloatArray(denom,  nC, "temp-denomPow.flt");
+    writeFloatArray(ratio,  nC, "temp-ratio.flt");
+    writeFloatArray(numAvg, nC-avgSam+1, "temp-numAvg.flt");
+    writeFloatArray(denAvg, nC-avgSam+1, "temp-denAvg.flt");
+    writeFloatArray(ratio,  nC, "temp-ratio.flt");
 #endif
     /* Exponentially decay numer (which is power per kHz of bandwidth), dividing
      * by running mean and leaving result in numer. Result (i.e., numer) is
      * called normPowNumer in MATLAB. */
-    expDecay(numer, nX, sRate, NULL, ep->decayTime, ep->decayTime,
-	     ep->ignoreThresh / bwNumer, ep->ignoreLimT, 1);
+    expDecay(&numer[nT], nX, sRate, &es->decayMean, &es->decayIgnore,
+	     ep->decayTime, ep->decayTime, ep->ignoreThresh / bwNumer,
+	     ep->ignoreLimT, 1);
+    memcpy(numer, tailNorm, nT * sizeof(numer[0]));
+    memcpy(tailNorm, &numer[nC - nNewT], nNewT * sizeof(numer[0]));
 
 #ifdef DEBUG_SAVE_ARRAYS
     //Same normPowNumer (here in numer).
     writeFloatArray(numer, nX, "temp-normPowNumer.flt");
 #endif
 
-    /* Find clicks - peaks in numer (which is normPowNumer) that also satisfy
-     * the ERMA ratio test. Click detection times are put into fc. */
-    int32 startClickNo = fc->n;
-    findClicks(numer, nX, segT0, ratio, nRatio, sRate, ep, delaySam, bwNumer,
-	       fc, seg, nSeg, origSRate);
+    sig->numer = numer;
+    sig->ratio = ratio;
+    sig->nX = nC;
+    sig->nRatio = nRatio;
+    sig->segT0 = segT0 - nT / sRate;
+    sig->sRate = sRate;
+    sig->delaySam = delaySam;
+    sig->bwNumer = bwNumer;
+    if (nT > 0) {
+	sig->warmSam = MAX(0, nT + es->nextI);
+	sig->nLow = es->nLow;
+    } else {
+	sig->warmSam = es->fresh ? round(ep->warmupS * sRate) : 0;
+	sig->nLow = 0;
+    }
+    es->nTail = nNewT;
 }
 
 /*
@@ -266,14 +556,26 @@ static void calcAverageRatio(float *num, float *den, int32 nNum,
  * start of the peak in x is above thresh, (b) there aren't past values in x
  * within refractorySam samples that are above peak, (c) the location of the
  * peak is adjusted to the highest value within nbdSam samples, and (d) the
- * ratio at the peak is above another threshold. The peaks found are stored in
- * fc along with their spectra. seg is the original signal, which is used only
- * for calculating spectra.
+ * ratio at the peak is above another threshold. x and ratio come from sig, and
+ * the warmup at the start of them is skipped. The peaks found are stored in fc
+ * along with their spectra. seg is the original signal, which is used only for
+ * calculating spectra; the spectra of all the clicks found in seg are
+ * calculated together at the end (see clickSpec.c).
+ *
+ * If es isn't NULL, where the search stopped is left in it, for the next
+ * segment's search to carry on from (see ermaSignals).
+ *
+ * If seg is NULL, spectra aren't calculated and fc->spec isn't touched. In that
+ * case nothing static is used, so several threads can run findClicks on the
+ * same sig at once, each with its own ep and fc (see ermaSweep.c).
  */
-void findClicks(float *x, int32 nX, float segT0, float *ratio, int32 nRatio,
-		float sRate, ERMAPARAMS *ep, int32 delaySam, float bwNumer,
-		FILECLICKS *fc, float *seg, size_t nSeg, float segSRate)
+void findClicks(ERMASIGNALS *sig, ERMAPARAMS *ep, FILECLICKS *fc,
+		float *seg, size_t nSeg, float segSRate, ERMASTATE *es)
 {
+    float *x = sig->numer, *ratio = sig->ratio;
+    int32 nX = sig->nX, nRatio = sig->nRatio, delaySam = sig->delaySam;
+    float sRate = sig->sRate, segT0 = sig->segT0;
+
 #ifdef DEBUG_SAVE_NBDS
     printf("findClicks: printing click nbds to file\n");
     FILE *fp = fopen("temp-ratioNbds.csv", "w");
@@ -282,19 +584,18 @@ void findClicks(float *x, int32 nX, float segT0, float *ratio, int32 nRatio,
 
     int32 nbdSam = round(ep->peakNbdT * sRate);
     int32 refractorySam = round(ep->refractoryT * sRate);
-    float powerThreshPerKHz = ep->powerThresh / bwNumer;
-    size_t nSpecSams = (size_t)round(ep->specLenS * sRate / SPECLEN) * SPECLEN;
-
-    //Set up Hanning window if needed.
-    static float win[NFFT];
-    static int winInitted = 0;
-    if (!winInitted) {
-	fftMakeWindow(win, WIN_HANNING, NFFT, 0);
-	winInitted = 1;
-    }
+    float powerThreshPerKHz = ep->powerThresh / sig->bwNumer;
+    //specLenS is measured in seg, which is at segSRate, not sRate.
+    size_t nSpecSams =
+	(size_t)round(ep->specLenS * segSRate / SPECLEN) * SPECLEN;
+
+    //Center of each click in seg, for calculating spectra after the loop.
+    static int64 *specIx = NULL;
+    static size_t specIxSize = 0;
+    int32 startClickNo = fc->n;
     
-    int32 nLow = 0;
-    int32 i = 0;
+    int32 nLow = sig->nLow;
+    int32 i = sig->warmSam;
     while (i < nRatio) {	//i can get changed inside the loop
 	if (x[i] <= powerThreshPerKHz) {
 	    nLow += 1;
@@ -305,20 +606,28 @@ void findClicks(float *x, int32 nX, float segT0, float *ratio, int32 nRatio,
 		int32 ixN = peakNear(x, nX, i, nbdSam);
 		/* Find corresponding high point in ratio[]. */
 		int32 ixR = peakNear(ratio, nRatio, i - delaySam, nbdSam);
+		float ratioR = ratio[ixR];
 #ifdef DEBUG_SAVE_NBDS
 		int32 segIx0 = segT0 * sRate;
 		fprintf(fp, "%d,%d,%d,%d,%d\n", ixN + segIx0,
 			i - delaySam - nbdSam + segIx0,
 			i - delaySam + nbdSam + 1 + segIx0,
-			ixR + segIx0, ratio[ixR] > ep->ratioThresh);
+			ixR + segIx0, ratioR > ep->ratioThresh);
 #endif
-		if (ratio[ixR] > ep->ratioThresh) {
+		if (ratioR > ep->ratioThresh) {
 		    /* Found a click. Add it to fc. */
 		    BUFGROW(fc->timeS, fc->n + 1, ERMA_NO_MEMORY_PEAK);
-/*		    BUFGROW(fc->spec, fc->n + 1, ERMA_NO_MEMORY_PEAK);*/
+		    BUFGROW(fc->ratioPk, fc->n + 1, ERMA_NO_MEMORY_PEAK);
+		    BUFGROW(fc->numerPk, fc->n + 1, ERMA_NO_MEMORY_PEAK);
 		    fc->timeS[fc->n] = (ixR + delaySam) / sRate + segT0;
-/*		    addSpec(fc->spec[fc->n], (float)ixN/sRate, seg, nSeg,*/
-/*			    segSRate, nSpecSams, win);*/
+		    fc->ratioPk[fc->n] = ratioR;
+		    fc->numerPk[fc->n] = x[ixN] * sig->bwNumer;
+		    if (seg != NULL) {
+			BUFGROW(specIx, fc->n - startClickNo + 1,
+				ERMA_NO_MEMORY_PEAK);
+			specIx[fc->n - startClickNo] =
+			    (int64)round((float)ixN / sRate * segSRate);
+		    }
 		    fc->n += 1;
 		    /* Advance i past this peak. Gets incremented below too. */
 		    i = MAX(i, ixR - delaySam);
@@ -331,65 +640,17 @@ void findClicks(float *x, int32 nX, float segT0, float *ratio, int32 nRatio,
 #ifdef DEBUG_SAVE_NBDS
     fclose(fp);
 #endif
-}
-
-
-/* Put a spectrum taken from the original signal seg in cs. The spectrum is
- * calculated for a series of sound segments of length NFFT; their power is
- * summed and then divided by the number of spectra to get the average power
- * spectrum for this click.
- */
-void addSpec(CLICKSPEC cs, float t, float *seg, size_t nSeg,
-	     float sRate, size_t nSpecSams, float *win)
-{
-    size_t ix = (size_t)round(t * sRate);
-    size_t ix0 = ix - nSpecSams/2;
-    size_t ix1 = ix + (nSpecSams + 1)/2;
-    float xRe[NFFT], xIm[NFFT];
-    float sumSpec[SPECLEN];
-
-    //Take care of endpoints.
-    if (ix0 < 0) {
-	ix1 -= ix0;
-	ix0 = 0;
-    }
-    if (ix1 > nSeg) {
-	ix0 -= ix1 - nSeg;
-	ix1 = nSeg;
-    }
-    if (ix0 < 0)
-	ix0 = 0;
-    
-    //Prepare sumSpec, which has the summed power spectra.
-    int32 nSumSpec = 0;	//number of spectra that get summed
-    for (int32 j = 0; j < SPECLEN; j++)
-	sumSpec[j] = 0.0;
-
-    for (size_t i = ix0; i + NFFT < ix1; i += SPECLEN) {
-	//Set up real and imaginary arrays. The latter starts off 0.
-	memcpy(xRe, &seg[i], NFFT * sizeof(xRe[0]));
-	for (int32 j = 0; j < NFFT; j++)
-	    xIm[j] = 0.0;
-	//Window the real part.
-	for (int32 j = 0; j < NFFT; j++)
-	    xRe[j] *= win[j];
-
-	//Calculate spectrum. It ends up in upper half, reversed.
-	fft(xRe, xIm, FFTM);
-
-	//Add summed power to sumSpec.
-	nSumSpec++;
-	for (int32 jSrc = SPECLEN, jDst = 0; jSrc < NFFT; jSrc++, jDst++)
-	    sumSpec[jDst] += xRe[jSrc]*xRe[jSrc] + xIm[jSrc]*xIm[jSrc];
+    if (es != NULL) {
+	es->nextI = i - nX;
+	es->nLow = nLow;
     }
-    //Put average power in output (cs). Also reverse sumSpec to get low
-    //frequencies first.
-    for (int32 j = 0, k = SPECLEN-1; j < SPECLEN; j++, k--)
-	cs[j] = sumSpec[k] / nSumSpec;
 
-#ifdef DEBUG_SAVE_SPECTRA
-    writeFloatArray(cs, SPECLEN, "temp-clickSpectrum.flt");
-#endif
+    /* Calculate the spectra of all the clicks just found. */
+    if (seg == NULL)
+	return;
+    BUFGROW(fc->spec, fc->n, ERMA_NO_MEMORY_PEAK);
+    clickSpecBatch(seg, nSeg, specIx, fc->n - startClickNo, nSpecSams,
+		   &fc->spec[startClickNo]);
 }
 
 
@@ -404,37 +665,6 @@ void writeFILECLICKS(FILECLICKS *fc, char *filename)
 }
 
 
-/* For debugging.
- */
-void writeALLCLICKS(ALLCLICKS *ac, char *filename)
-{
-    FILE *fp = fopen(filename, "w");
-    for (int32 i = 0; i < ac->n; i++) {
-	double timeE_dbl = ac->timeD[i] * 24*60*60;
-	time_t timeE_int = (time_t)floor(timeE_dbl);
-	char *asc = asctime(gmtime(&timeE_int));
-	float fracSec = remainder(timeE_dbl, 1.0L);
-	fprintf(fp, "%s%4.3f\n", asc, fracSec);
-    }
-    fclose(fp);
-}
-
-
-/* Append the clicks in the FILECLICKS fc, which has seconds in a file, to the
- * ALLCLICKS ac, which has days since the Epoch.
- */
-void appendClicks(ALLCLICKS *ac, FILECLICKS *fc, double fileTimeE)
-{
-    int32 i, j;
-    double secPerDay = 24*60*60;
-    
-    BUFGROW(ac->timeD, ac->n + fc->n, ERMA_NO_MEMORY_APPENDCLICKS);
-    for (i = 0, j = ac->n; i < fc->n; i++, j++)
-	ac->timeD[j] = ((double)fc->timeS[i] + fileTimeE) / secPerDay;
-    ac->n += fc->n;
-}
-
-
 /* Find the highest value in x within nbd samples around x[ix] and return its
  * index.
  */
@@ -451,24 +681,29 @@ int32 peakNear(float *x, int32 nX, int32 ix, int32 nbd)
 
 /* Save detections to outPath. A base time of the start of the file is written
  * first as seconds since The Epoch, then all detections are written as seconds
- * since that base time (since start of file).
+ * since that base time (since start of file). The line is made in memory and
+ * goes to outPath by way of the journal (see journal.h).
  */
 void saveNewClicks(ALLCLICKS *allC, int32 startN, double fileTimeE,
 		   char *outPath, char *inPath)
 {
     const double secPerDay = 24*60*60;
-    FILE *fp = fopen(outPath, "a");
-
-    if (fp != NULL) {
-	if (allC->n > startN) {
-	    double baseTime_D = fileTimeE / secPerDay;
-/*	    double baseTime_D = allC->timeD[0];	//times are measured from this*/
-	    fprintf(fp, "$clickDet,%s,%.3lf",
-		    pathFile(inPath), baseTime_D * secPerDay);
-	    for (int32 i = startN; i < allC->n; i++) 
-		fprintf(fp, ",%.3lf", (allC->timeD[i]- baseTime_D) * secPerDay);
-	    fprintf(fp, "\n");
-	}
-	fclose(fp);
-    }
+    static char *line = NULL;
+    static size_t lineSize = 0;
+
+    if (allC->n <= startN)
+	return;
+
+    /* Each click takes at most 1+20+1+3 chars. */
+    BUFGROW(line, (size_t)(allC->n - startN) * 25 + 600, ERMA_NO_MEMORY_PEAK);
+    double baseTime_D = fileTimeE / secPerDay;
+    char *p = line + snprintf(line, 600, "$clickDet,%s,%.3lf",
+			      pathFile(inPath), baseTime_D * secPerDay);
+    CLICKITER it;
+    double tD;
+    clickIterStart(&it, allC, startN);
+    while (clickIterNext(&it, &tD))
+	p = putMillis(p, (tD - baseTime_D) * secPerDay);
+    *p++ = '\n';
+    journalAppend(outPath, line, p - line);
 }
@@ -2,13 +2,19 @@
 #define _ERMANEW_H_
 
 /* A click spectrum. Points are approximately 0.5 kHz apart, though this is
- * affected by the sample rate and nearest power of 2.
+ * affected by the sample rate and nearest power of 2. To keep memory use per
+ * click small, each point is stored as quantized dB in one byte: a stored value
+ * q means SPEC_DB_MIN + q*SPEC_DB_STEP dB, so the range covered is 0 to 191 dB
+ * (enough for 24-bit samples) in 0.75-dB steps. See clickSpec.c.
  */
 #define FFTM	8		//log2(FFT size)
 #define NFFT	(1 << FFTM)	//FFT size; twice the spectrum size
 #define SPECLEN	(NFFT/2)	//# points in a spectrum; a power of 2
+#define SPEC_DB_MIN	0.0	//dB value of a stored 0
+#define SPEC_DB_STEP	0.75	//dB per step of the stored value
 
-typedef float CLICKSPEC[SPECLEN];
+typedef uint8_t CLICKSPEC[SPECLEN];
+#define CLICKSPEC_DB(q)	(SPEC_DB_MIN + (q) * SPEC_DB_STEP)  //q back to dB
 
 
 /* FILECLICKS holds the whale clicks found in a single file.
@@ -18,28 +24,85 @@ typedef struct {
     size_t timeSSize;	/* for bufgrow */
     CLICKSPEC *spec;	/* spectrum of each click in timeS */
     size_t specSize;	/* for bufgrow */
+    float *ratioPk;	/* ratio at each click's peak */
+    size_t ratioPkSize;	/* for bufgrow */
+    float *numerPk;	/* numerator power at each click's peak, in the units
+			 * of powerThresh */
+    size_t numerPkSize;	/* for bufgrow */
     int32_t n;		/* number of clicks found this file */
 } FILECLICKS;
 
 
-/* ALLCLICKS holds the whale clicks found in all files. As such, it encodes time
- * using doubles so as to have enough bit resolution (to at least milliseconds).
+/* ALLCLICKS holds the whale clicks found in all files. It's defined in
+ * allClicks.h.
+ */
+typedef struct allclicks ALLCLICKS;
+
+
+/* ERMASIGNALS has the intermediate signals that click detection (findClicks)
+ * works from for one segment. They depend on the filters, avgT, decayTime, and
+ * the ignore params, but not on powerThresh, ratioThresh, refractoryT, or
+ * peakNbdT, so they can be re-used when only those change (see ermaSweep.c).
+ */
+typedef struct {
+    float *numer;	/* normalized numerator power (normPowNumer) */
+    float *ratio;	/* ratio of averaged numerator and denominator power */
+    int32_t nX;		/* length of numer */
+    int32_t nRatio;	/* length of ratio */
+    float segT0;	/* start time of the segment in the file, s */
+    float sRate;	/* sample rate of numer and ratio */
+    int32_t delaySam;	/* numer[i] aligns with ratio[i - delaySam] */
+    float bwNumer;	/* bandwidth of the numerator band, kHz */
+    int32_t warmSam;	/* numer[0..warmSam-1] is filter warmup, or was
+			 * searched in the last segment; skip it */
+    int32_t nLow;	/* findClicks' run of low samples before warmSam */
+} ERMASIGNALS;
+
+
+/* ERMASTATE is the part of a profile's signal-processing state, apart from its
+ * filters' state (which is in its ERMAFILT), that's carried from one segment to
+ * the next when they're contiguous in time. See ermaContinue. Within a file,
+ * the end of one segment's signals is also carried into the next, so the
+ * click search can go right up to the boundary (see ermaSignals).
  */
 typedef struct {
-    double *timeD;	/* click times, in *days* since the Epoch (1/1/1970) */
-    size_t timeDSize;	/* for bufgrow */
-    int32_t n;		/* number of elements in timeD */
-} ALLCLICKS;
+    float decayMean;	/* expDecay's running mean; < 0 means start afresh */
+    int32_t decayIgnore;/* expDecay's count of loud samples being ignored */
+    int fresh;		/* 1 if the state was reset for the current segment */
+    float *tail;	/* the carried numer power, denom power, and
+			 * normPowNumer; see ermaSignals */
+    size_t tailSize;	/* for bufgrow */
+    int32_t nTail;	/* # of samples of each in tail; 0 = none carried */
+    int32_t nextI;	/* where findClicks stopped, relative to the end of
+			 * the last segment's signals */
+    int32_t nLow;	/* findClicks' run of low samples at that point */
+} ERMASTATE;
+
+
+/* An ERMAPROFILE is one of possibly several detectors run on the same data.
+ * It's defined in ermaProfile.h.
+ */
+typedef struct ermaprofile ERMAPROFILE;
 
 
 void initFILECLICKS(FILECLICKS *fc);
 void resetFILECLICKS(FILECLICKS *fc);
-void initALLCLICKS(ALLCLICKS *ac);
+void initERMASTATE(ERMASTATE *es);
+void resetERMASTATE(ERMASTATE *es);
+int ermaContinue(WISPRINFO *wi, TIMESPAN_S *span, int newFile,
+		 ERMAPARAMS *ep, ERMAPROFILE *prof, int32 nProf);
+void ermaGateGetStats(int64_t *pNIn, int64_t *pNPassed);
 void ermaSegments(float *snd, WISPRINFO *wi, ERMAPARAMS *ep, QUIETTIMES *qt,
-		  FILECLICKS *fc);
+		  ERMAPROFILE *prof, int32 nProf);
+void ermaMoreSegments(float *snd, WISPRINFO *wi, ERMAPARAMS *ep,
+		      QUIETTIMES *qt, int newFile, ERMAPROFILE *prof,
+		      int32 nProf);
 void ermaNew(float *seg, int32_t nSam, float segT0, float sRate, ERMAPARAMS *ep,
-	     FILECLICKS *fc);
-void appendClicks(ALLCLICKS *ac, FILECLICKS *fc, double fileTime);
+	     ERMAPROFILE *prof, int32 nProf);
+void ermaSignals(float *x, int32_t nX, float segT0, float sRate,
+		 float origSRate, ERMAPROFILE *prof, ERMASIGNALS *sig);
+void findClicks(ERMASIGNALS *sig, ERMAPARAMS *ep, FILECLICKS *fc,
+		float *seg, size_t nSeg, float segSRate, ERMASTATE *es);
 void saveNewClicks(ALLCLICKS *allC, int32 startN, double fileTimeE,
 		   char *outPath, char *inPath);
 
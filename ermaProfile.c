@@ -0,0 +1,192 @@
+
+#include "erma.h"
+
+/* Several detectors, or "profiles", can be run at once on the same data, each
+ * with its own set of parameters. In rpi.cnf, list their names like
+ *
+ *		profiles = sperm, beaked, dolphin
+ *
+ * and then give each one's parameters that differ from the ordinary (base)
+ * ones by putting the profile name and a '.' in front, like
+ *
+ *		beaked.powerThresh = 50
+ *		beaked.numerN = 7
+ *		beaked.numerA = 1, -4.6, ...
+ *		beaked.numerB = 0.005, -0.0076, ...
+ *		beaked.numerBand = 16000, 24000
+ *
+ * A profile that gives numerN or denomN must give both of its A and B arrays;
+ * one that doesn't can give just numerB, say, and keep the base numerA.
+ * Things that are shared by all profiles come from the base params only: the
+ * bookkeeping file names, GPIO pins, the downsampling filter (dsfA/B/N and
+ * decim), and the ns_* noise params. Each profile's click and encounter files
+ * have the profile name in them (see ermaProfileSetPaths).
+ *
+ * If rpi.cnf has no 'profiles' line, there's a single profile with an empty
+ * name that uses the base params, and output files are named as they've always
+ * been.
+ */
+
+
+/* Make a new ERMACONFIG with just the entries in ec that start with
+ * "<name>.", with that prefix removed from the varnames.
+ */
+static ERMACONFIG *profileConfig(ERMACONFIG *ec, char *name)
+{
+    ERMACONFIG *sub = newERMACONFIG();
+    size_t len = strlen(name);
+
+    for (int32 i = 0; i < ec->n; i++) {
+	if (!strncmp(ec->varname[i], name, len) && ec->varname[i][len] == '.') {
+	    BUFGROW(sub->varname, sub->n + 1, ERMA_NO_MEMORY_CONFIGVAR);
+	    BUFGROW(sub->value,   sub->n + 1, ERMA_NO_MEMORY_CONFIGVAR);
+	    sub->varname[sub->n] = strsave(&ec->varname[i][len + 1]);
+	    sub->value  [sub->n] = strsave(ec->value[i]);
+	    sub->n++;
+	}
+    }
+    return sub;
+}
+
+
+/* Set up one profile. Its params are a copy of ep with any overrides for this
+ * profile in ec applied. ec may be NULL for no overrides.
+ */
+static void initProfile(ERMAPROFILE *prof, char *name, ERMACONFIG *ec,
+			ERMAPARAMS *ep)
+{
+    prof->name = name;
+    prof->ep = *ep;
+    copyFilterCoeffs(&prof->ep);	//so overrides don't change ep's
+    if (ec != NULL) {
+	/* The sub-config isn't deleted, as string params point into it. */
+	gatherErmaParams(profileConfig(ec, name), &prof->ep);
+    }
+    ermaFiltInit(&prof->filt, &prof->ep);
+    initERMASTATE(&prof->state);
+    initFILECLICKS(&prof->fileC);
+    initALLCLICKS(&prof->allC);
+    initENCOUNTERS(&prof->enc);
+    initENCSTATE(&prof->encState);
+    prof->allDetsPath[0] = prof->allDetsBinPath[0] = '\0';
+    prof->piEncDetsPath[0] = '\0';
+    prof->wisprEncDetsPath[0] = prof->encStatePath[0] = '\0';
+    prof->clickLogPath[0] = '\0';
+}
+
+
+/* Make the list of detector profiles from the 'profiles' line in ec (see the
+ * top of this file). The base params are in ep. The new array of profiles is
+ * returned in *pProf, and the number of them is the return value; this is
+ * always at least 1.
+ */
+int32 ermaGetProfiles(ERMACONFIG *ec, ERMAPARAMS *ep, ERMAPROFILE **pProf)
+{
+    ERMAPROFILE *prof = NULL;
+    size_t profSize = 0;		//for bufgrow
+    int32 nProf = 0;
+    char *names = NULL;
+
+    if (ermaGetString(ec, "profiles", &names)) {
+	/* Names are separated by commas and/or white space. strtok alters the
+	 * string it's given, so use a copy, which also holds the names. */
+	names = strsave(names);
+	for (char *nm = strtok(names, ", \t"); nm; nm = strtok(NULL, ", \t")) {
+	    BUFGROW(prof, nProf + 1, ERMA_NO_MEMORY_PROFILE);
+	    initProfile(&prof[nProf++], nm, ec, ep);
+	}
+    }
+    if (nProf == 0) {
+	BUFGROW(prof, 1, ERMA_NO_MEMORY_PROFILE);
+	initProfile(&prof[nProf++], "", NULL, ep);
+    }
+    *pProf = prof;
+    return nProf;
+}
+
+
+/* Construct the names of a profile's output files. fileTimestamp is normally
+ * the date/time stamp of the first input file of this run. If the profile has a
+ * name, it goes between the file-name prefix and fileTimestamp.
+ */
+void ermaProfileSetPaths(ERMAPROFILE *prof, char *baseDir, char *fileTimestamp)
+{
+    ERMAPARAMS *ep = &prof->ep;
+    char tag[128];
+
+    if (prof->name[0] == '\0')
+	snprintf(tag, sizeof(tag), "%s", fileTimestamp);
+    else
+	snprintf(tag, sizeof(tag), "%s-%s", prof->name, fileTimestamp);
+
+    snprintf(prof->allDetsPath, sizeof(prof->allDetsPath), "%s/%s/%s-%s.csv",
+	     baseDir, ep->outDir, ep->allDetsPrefix, tag);
+    if (ep->allDetsBinary)
+	snprintf(prof->allDetsBinPath, sizeof(prof->allDetsBinPath),
+		 "%s/%s/%s-%s.bin",
+		 baseDir, ep->outDir, ep->allDetsPrefix, tag);
+    //piEncDetsPath is in baseDir, not baseDir/outDir.
+    snprintf(prof->piEncDetsPath, sizeof(prof->piEncDetsPath), "%s/%s-%s.csv",
+	     baseDir, ep->encDetsPrefix, tag);
+    char *sep = (strlen(ep->wisprEncFileDir) > 0) ? "/" : "";
+    snprintf(prof->wisprEncDetsPath, sizeof(prof->wisprEncDetsPath),
+	     "%s%s%s-%s.csv", ep->wisprEncFileDir, sep, ep->encDetsPrefix, tag);
+    //The encounter state carries over between runs, so it has no timestamp.
+    snprintf(prof->encStatePath, sizeof(prof->encStatePath), "%s/%s%s%s",
+	     baseDir, ep->encStateFileName, prof->name[0] ? "-" : "", prof->name);
+    //So does the click log.
+    if (ep->clickLogFileName[0] != '\0')
+	snprintf(prof->clickLogPath, sizeof(prof->clickLogPath),
+		 "%s/%s/%s%s%s", baseDir, ep->outDir, ep->clickLogFileName,
+		 prof->name[0] ? "-" : "", prof->name);
+}
+/**********************************************************************/
+
+
+/* This tests that a profile that overrides just numerB gets its own filter
+ * without changing the base params' or another profile's. Compile with
+ *
+ *	cc -O2 -DPROFILE_MAIN -include erma.h ermaProfile.c ermaConfig.c \
+ *	    ermaFilt.c iirFilter.c ermaNew.c expDecay.c allClicks.c \
+ *	    encounters.c encReport.c clickSpec.c fft.c journal.c \
+ *	    ermaGoodies.c -lm
+ */
+#ifdef PROFILE_MAIN
+static void testSet(ERMACONFIG *ec, char *varname, char *value)
+{
+    BUFGROW(ec->varname, ec->n + 1, ERMA_NO_MEMORY_CONFIGVAR);
+    BUFGROW(ec->value,   ec->n + 1, ERMA_NO_MEMORY_CONFIGVAR);
+    ec->varname[ec->n] = strsave(varname);
+    ec->value  [ec->n] = strsave(value);
+    ec->n++;
+}
+
+
+int main(int argc, char **argv)
+{
+    ERMACONFIG *ec = newERMACONFIG();
+    ERMAPARAMS ep;
+    ERMAPROFILE *prof;
+    float baseB[] = { 0.1, 0.2, 0.1 }, newB[] = { 0.3, 0.4, 0.3 };
+
+    memset(&ep, 0, sizeof(ep));
+    testSet(ec, "numerN", "3");
+    testSet(ec, "numerA", "1, -0.5, 0.25");
+    testSet(ec, "numerB", "0.1, 0.2, 0.1");
+    testSet(ec, "profiles", "a, b");
+    testSet(ec, "b.numerB", "0.3, 0.4, 0.3");
+    gatherErmaParams(ec, &ep);
+    int32 nProf = ermaGetProfiles(ec, &ep, &prof);
+
+    int ok = (nProf == 2);
+    for (int i = 0; ok && i < NUM_OF(baseB); i++)
+	ok = (ep.numerB[i] == baseB[i] && prof[0].ep.numerB[i] == baseB[i] &&
+	      prof[0].filt.numer.B[i] == baseB[i] &&
+	      prof[1].ep.numerB[i] == newB[i] &&
+	      prof[1].filt.numer.B[i] == newB[i] &&
+	      prof[1].ep.numerA[i] == ep.numerA[i]);
+    printf(ok ? "OK\n" : "FAILED\n");
+    return !ok;
+}
+#endif	/* PROFILE_MAIN */
+/**********************************************************************/
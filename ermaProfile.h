@@ -0,0 +1,33 @@
+#ifndef _ERMAPROFILE_H_
+#define _ERMAPROFILE_H_
+
+/* An ERMAPROFILE is one named detector -- e.g., for sperm whales, beaked whales,
+ * or dolphins -- run on the same data as any others. All the profiles share the
+ * reading of each file, the quiet-time calculation, and the downsampling; each
+ * then has its own band filters, ERMA ratio, click detection, and output files.
+ * See ermaProfile.c for how profiles are specified in rpi.cnf.
+ *
+ * (The typedef for ERMAPROFILE is in ermaNew.h, which needs it first.)
+ */
+struct ermaprofile {
+    char *name;		//name from rpi.cnf; "" for the single default profile
+    ERMAPARAMS ep;	//base params with this profile's overrides applied
+    ERMAFILT filt;	//numerator and denominator filters and their state
+    ERMASTATE state;	//other DSP state carried between segments
+    FILECLICKS fileC;	//clicks found in the current file
+    ALLCLICKS allC;	//clicks found in all files this run
+    ENCOUNTERS enc;	//encounters found in allC
+    ENCSTATE encState;	//where findEncounters left off, maybe in an earlier run
+    char allDetsPath[256];	//stores all click dets
+    char allDetsBinPath[256];	//binary copy of them; "" if none
+    char piEncDetsPath[256];	//name here of encounter clicks file
+    char wisprEncDetsPath[256];	//name on WISPR of encounter clicks file
+    char encStatePath[256];	//saved encState
+    char clickLogPath[256];	//binary log of all clicks; "" if none
+};
+
+int32 ermaGetProfiles(ERMACONFIG *ec, ERMAPARAMS *ep, ERMAPROFILE **pProf);
+void ermaProfileSetPaths(ERMAPROFILE *prof, char *baseDir,
+			 char *fileTimestamp);
+
+#endif	/* _ERMAPROFILE_H_ */
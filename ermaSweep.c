@@ -0,0 +1,548 @@
+
+#include "erma.h"
+#include <pthread.h>
+
+/* Parameter sweep: run one detector profile over a set of soundfiles with a
+ * grid of detection parameters, reporting how many clicks each grid point
+ * finds and, if a labels file is given, its precision and recall. It's run as
+ *
+ *		ErmaMain -sweep [soundfile ...]
+ *
+ * With no soundfiles, all files matching infilePattern are used. Nothing is
+ * added to files_processed.txt and no detection or encounter files are written.
+ *
+ * The four params that are swept - powerThresh, ratioThresh, refractoryT, and
+ * peakNbdT - are used only in findClicks, not in the filtering that comes
+ * before it. So each file is read, filtered, and turned into ERMA signals (see
+ * ERMASIGNALS in ermaNew.h) just once; these are kept in memory and findClicks
+ * is run on them for every grid point, with the grid points split among
+ * several threads.
+ *
+ * The grid and the other sweep settings come from rpi.cnf:
+ *
+ *		sweep.powerThresh = 25, 50, 100, 200
+ *		sweep.ratioThresh = 2, 4, 8
+ *		sweep.refractoryT = 0.01
+ *		sweep.peakNbdT = 0.005
+ *		sweep.profile = sperm		(default is the first profile)
+ *		sweep.labels = labels.csv	(in baseDir; default is none)
+ *		sweep.matchTolS = 0.005		(see matchClicks below)
+ *		sweep.threads = 4
+ *		sweep.outFile = sweep.csv	(in baseDir/outDir)
+ *
+ * A swept param that's missing keeps the profile's value. The labels file has
+ * the same format as an all_dets file - one "$clickDet,<file>,<timeE>,<t>,..."
+ * line per soundfile with click times in s from the start of the file - so a
+ * hand-checked all_dets file can be used as labels. Soundfiles that don't
+ * appear in it are taken to have no clicks.
+ *
+ * Quiet times are found as usual, but the recent noise percentiles are kept in
+ * sweep_percentiles instead of saved_percentiles so the sweep doesn't disturb
+ * the noise history of regular runs.
+ */
+
+#define MAX_SWEEP_VALS	64	//max number of values for each swept param
+
+
+/* One grid point and its running totals over all files.
+ */
+typedef struct {
+    float powerThresh, ratioThresh, refractoryT, peakNbdT;
+    int64 nClicks;		//clicks detected
+    int64 nMatched;		//...of which this many matched a label
+} SWEEPPOINT;
+
+
+/* The click labels for each soundfile.
+ */
+typedef struct {
+    char **file;		//soundfile names, without directory
+    size_t fileSize;		//for bufgrow
+    float **timeS;		//label times in each file, sorted
+    size_t timeSSize;		//for bufgrow
+    int32 *nTime;		//number of labels in each file
+    size_t nTimeSize;		//for bufgrow
+    int32 n;			//number of files
+} SWEEPLABELS;
+
+
+/* What each thread works on: grid points first, first+step, first+2*step, ...
+ * are run on the cached signals for the current file.
+ */
+typedef struct {
+    SWEEPPOINT *pts;
+    int32 nPts, first, step;
+    ERMAPARAMS *ep;		//profile's params; swept ones get replaced
+    ERMASIGNALS *sig;		//cached signals, one per quiet-time segment
+    int32 nSig;
+    int useLabels;		//whether lab has this file's labels
+    float *lab;			//labels for this file; NULL if it has none
+    int32 nLab;
+    float tolS;
+    FILECLICKS fc;		//thread's own click buffer
+    float *det;			//fc's times, sorted (see matchClicks)
+    size_t detSize;		//for bufgrow
+} SWEEPTHREAD;
+
+
+static int cmpFloat(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+
+/* Read a labels file, which is in all_dets format (see saveNewClicks).
+ * Returns the number of soundfiles it has labels for; a missing file gives 0.
+ */
+static int32 readLabels(char *path, SWEEPLABELS *sl)
+{
+    FILE *fp = fopen(path, "r");
+    char *ln = NULL;
+    size_t lnSize = 0;
+
+    memset(sl, 0, sizeof(*sl));
+    if (fp == NULL)
+	return 0;
+    while (getline(&ln, &lnSize, fp) > 0) {
+	char *tok = strtok(ln, ",\r\n");
+	if (tok == NULL || strcmp(tok, "$clickDet"))
+	    continue;
+	char *fn = strtok(NULL, ",\r\n");
+	if (fn == NULL || strtok(NULL, ",\r\n") == NULL)	//skip timeE
+	    continue;
+	BUFGROW(sl->file,  sl->n + 1, ERMA_NO_MEMORY_SWEEP);
+	BUFGROW(sl->timeS, sl->n + 1, ERMA_NO_MEMORY_SWEEP);
+	BUFGROW(sl->nTime, sl->n + 1, ERMA_NO_MEMORY_SWEEP);
+	float *t = NULL;
+	size_t tSize = 0;		//for bufgrow
+	int32 nT = 0;
+	for (tok = strtok(NULL, ",\r\n"); tok; tok = strtok(NULL, ",\r\n")) {
+	    BUFGROW(t, nT + 1, ERMA_NO_MEMORY_SWEEP);
+	    t[nT++] = atof(tok);
+	}
+	qsort(t, nT, sizeof(t[0]), cmpFloat);
+	sl->file[sl->n] = strsave(fn);
+	sl->timeS[sl->n] = t;
+	sl->nTime[sl->n] = nT;
+	sl->n++;
+    }
+    free(ln);
+    fclose(fp);
+    return sl->n;
+}
+
+
+/* Count how many of the nDet detections in det are within tolS seconds of
+ * one of the nLab labels in lab. Each label matches at most one detection.
+ * Both have to be in order for this, so det is sorted into *pSorted (whose
+ * size for bufgrow is *pSortedSize) first, as findClicks doesn't always find
+ * clicks in time order (e.g., if peakNbdT > refractoryT); lab must already be
+ * sorted. With a fixed tolerance, pairing them off in order like this gives
+ * the most matches possible.
+ */
+static int32 matchClicks(float *detIn, int32 nDet, float *lab, int32 nLab,
+			 float tolS, float **pSorted, size_t *pSortedSize)
+{
+    int32 i = 0, j = 0, nMatched = 0;
+
+    BUFGROW(*pSorted, MAX(1, nDet), ERMA_NO_MEMORY_SWEEP);
+    float *det = *pSorted;
+    memcpy(det, detIn, nDet * sizeof(det[0]));
+    qsort(det, nDet, sizeof(det[0]), cmpFloat);
+
+    while (i < nDet && j < nLab) {
+	if (fabsf(det[i] - lab[j]) <= tolS) {
+	    nMatched++;
+	    i++;
+	    j++;
+	} else if (det[i] < lab[j])
+	    i++;
+	else
+	    j++;
+    }
+    return nMatched;
+}
+
+
+/* Thread body: run findClicks for this thread's share of the grid points on
+ * all of the current file's segments. findClicks is given no segment signal,
+ * so it doesn't do spectra and doesn't use any static buffers.
+ */
+static void *sweepThread(void *arg)
+{
+    SWEEPTHREAD *st = (SWEEPTHREAD *)arg;
+    ERMAPARAMS ep = *st->ep;
+
+    for (int32 k = st->first; k < st->nPts; k += st->step) {
+	SWEEPPOINT *pt = &st->pts[k];
+	ep.powerThresh = pt->powerThresh;
+	ep.ratioThresh = pt->ratioThresh;
+	ep.refractoryT = pt->refractoryT;
+	ep.peakNbdT    = pt->peakNbdT;
+	resetFILECLICKS(&st->fc);
+	for (int32 s = 0; s < st->nSig; s++)
+	    findClicks(&st->sig[s], &ep, &st->fc, NULL, 0, 0, NULL);
+	pt->nClicks += st->fc.n;
+	if (st->useLabels)
+	    pt->nMatched += matchClicks(st->fc.timeS, st->fc.n, st->lab,
+					st->nLab, st->tolS, &st->det,
+					&st->detSize);
+    }
+    return NULL;
+}
+
+
+/* Get the values for swept param 'name' from "sweep.<name>" in ec, or use
+ * dflt if it's not there. Returns the number of values.
+ */
+static int32 sweepValues(ERMACONFIG *ec, char *name, float dflt, float *vals)
+{
+    char varname[64];
+
+    snprintf(varname, sizeof(varname), "sweep.%s", name);
+    int32 n = ermaGetFloatArray(ec, varname, vals, MAX_SWEEP_VALS);
+    if (n <= 0) {
+	vals[0] = dflt;
+	n = 1;
+    }
+    return n;
+}
+
+
+/* Return the profile named by sweep.profile in ec, or the first one if there's
+ * no sweep.profile, or NULL if there's no profile by that name.
+ */
+static ERMAPROFILE *sweepProfile(ERMACONFIG *ec, ERMAPROFILE *prof,
+				 int32 nProf)
+{
+    char *profName = NULL;
+
+    if (!ermaGetString(ec, "sweep.profile", &profName))
+	return &prof[0];
+    for (int32 p = 0; p < nProf; p++)
+	if (!strcmp(prof[p].name, profName))
+	    return &prof[p];
+    printf("ermaSweep: no profile named '%s'\n", profName);
+    return NULL;
+}
+
+
+/* Read the labels file named by sweep.labels in ec, if there is one, into sl.
+ * Returns 1 if there's a labels file, 0 if not.
+ */
+static int sweepLabels(ERMACONFIG *ec, char *baseDir, SWEEPLABELS *sl)
+{
+    char *labelsName = NULL;
+    char path[256];
+
+    if (!ermaGetString(ec, "sweep.labels", &labelsName))
+	return 0;
+    snprintf(path, sizeof(path), "%s/%s", baseDir, labelsName);
+    printf("ermaSweep: %d file(s) labeled in %s\n", readLabels(path, sl), path);
+    return 1;
+}
+
+
+/* Find the labels in sl for soundfile path. Returns them, or NULL if the file
+ * has none, with the number of them in *pNLab.
+ */
+static float *fileLabels(SWEEPLABELS *sl, char *path, int32 *pNLab)
+{
+    int32 li = sl->n ? findInList(pathFile(path), sl->file) : -1;
+
+    *pNLab = (li >= 0) ? sl->nTime[li] : 0;
+    return (li >= 0) ? sl->timeS[li] : NULL;
+}
+
+
+/* Run the sweep over the NULL-terminated list of soundfiles in files. ec is the
+ * config from rpi.cnf, ep the base params, and prof the nProf detector
+ * profiles. Returns an exit code for main().
+ */
+int ermaSweep(char **files, ERMACONFIG *ec, ERMAPARAMS *ep,
+	      ERMAPROFILE *prof, int32 nProf, char *baseDir)
+{
+    char path[256];
+
+    /* Pick the profile to sweep. */
+    ERMAPROFILE *pr = sweepProfile(ec, prof, nProf);
+    if (pr == NULL)
+	return ERMA_SWEEP_BAD_PROFILE;
+
+    /* Make the grid of points. */
+    static float pwr[MAX_SWEEP_VALS], rat[MAX_SWEEP_VALS];
+    static float ref[MAX_SWEEP_VALS], nbd[MAX_SWEEP_VALS];
+    int32 nPow = sweepValues(ec, "powerThresh", pr->ep.powerThresh, pwr);
+    int32 nRat = sweepValues(ec, "ratioThresh", pr->ep.ratioThresh, rat);
+    int32 nRef = sweepValues(ec, "refractoryT", pr->ep.refractoryT, ref);
+    int32 nNbd = sweepValues(ec, "peakNbdT",    pr->ep.peakNbdT,    nbd);
+    int32 nPts = nPow * nRat * nRef * nNbd;
+    SWEEPPOINT *pts = (SWEEPPOINT *)calloc(nPts, sizeof(SWEEPPOINT));
+    if (pts == NULL)
+	exit(ERMA_NO_MEMORY_SWEEP);
+    for (int32 k = 0, a = 0; a < nPow; a++)
+	for (int32 b = 0; b < nRat; b++)
+	    for (int32 c = 0; c < nRef; c++)
+		for (int32 d = 0; d < nNbd; d++, k++) {
+		    pts[k].powerThresh = pwr[a];
+		    pts[k].ratioThresh = rat[b];
+		    pts[k].refractoryT = ref[c];
+		    pts[k].peakNbdT    = nbd[d];
+		}
+
+    /* Other settings. */
+    SWEEPLABELS sl;
+    int haveLabels = sweepLabels(ec, baseDir, &sl);
+    float tolS = 0.005;
+    ermaGetFloat(ec, "sweep.matchTolS", &tolS);
+    int32 nThreads = 4;
+    ermaGetInt32(ec, "sweep.threads", &nThreads);
+    nThreads = MAX(1, MIN(nThreads, nPts));
+    char *outName = "sweep.csv";
+    ermaGetString(ec, "sweep.outFile", &outName);
+
+    /* Open the output now, so a bad outDir shows up before the sweep runs. */
+    snprintf(path, sizeof(path), "%s/%s/%s", baseDir, ep->outDir, outName);
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+	printf("ermaSweep: can't write %s\n", path);
+	return ERMA_SWEEP_CANT_WRITE;
+    }
+
+    /* Quiet-time params are shared, but keep the sweep's noise history apart
+     * from that of regular runs. */
+    ERMAPARAMS qep = *ep;
+    qep.pctFileName = "sweep_percentiles";
+    ermaFiltPrep(ep);
+
+    printf("ermaSweep: profile '%s', %d grid points, %d threads\n",
+	   pr->name, nPts, nThreads);
+
+    static SWEEPTHREAD st[64];
+    nThreads = MIN(nThreads, NUM_OF(st));
+    for (int32 t = 0; t < nThreads; t++) {
+	st[t].pts = pts;
+	st[t].nPts = nPts;
+	st[t].first = t;
+	st[t].step = nThreads;
+	st[t].ep = &pr->ep;
+	st[t].tolS = tolS;
+	initFILECLICKS(&st[t].fc);
+	st[t].det = NULL;
+	st[t].detSize = 0;
+    }
+
+    /* The signal cache. Signals for all of a file's segments go end-to-end in
+     * numer and ratio; sig[] has offsets into them until the file is done and
+     * the buffers have stopped moving, and then real pointers. */
+    static float *numer = NULL, *ratio = NULL, *x = NULL, *snd = NULL;
+    static size_t numerSize = 0, ratioSize = 0, xSize = 0, sndSize = 0;
+    static ERMASIGNALS *sig = NULL;
+    static size_t sigSize = 0;
+    QUIETTIMES qt;
+    initQUIETTIMES(&qt);
+    int64 nLabels = 0;
+    double tFilt = 0, tFind = 0;
+    int32 nFiles = 0;
+
+    for (int32 f = 0; files[f] != NULL; f++) {
+	WISPRINFO wi;
+	wisprInitWISPRINFO(&wi);
+	if (!wisprReadHeader(&wi, files[f]))
+	    continue;
+	printf("#%d ermaSweep: %s\n", f + 1, files[f]);
+	double t0 = nowSec();
+	void *raw = wisprReadRaw(&wi);
+	resetQuietTimes(&qt);
+	findQuietTimesRaw(raw, &wi, &qep, &qt, baseDir);
+	decodeQuietTimes(raw, &wi, &qt, &snd, &sndSize);
+
+	/* Compute the ERMA signals for each segment and cache them. */
+	size_t nNumer = 0, nRatio = 0, off = 0;
+	int32 nSig = 0;
+	for (int32 i = 0; i < qt.n; i++) {
+	    int32 nSeg = qt.tSpan[i].sam1 - qt.tSpan[i].sam0;
+	    int32 nX;
+	    float newSRate;
+	    ermaContinue(&wi, &qt.tSpan[i], i == 0, ep, pr, 1);
+	    BUFGROW(x, nSeg, ERMA_NO_MEMORY_DECIMBUF);
+	    ermaDownsample(&snd[off], nSeg, ep->decim, x, &nX, wi.sRate,
+			   &newSRate);
+	    off += nSeg;
+	    BUFGROW(sig, nSig + 1, ERMA_NO_MEMORY_SWEEP);
+	    ERMASIGNALS *s = &sig[nSig++];
+	    ermaSignals(x, nX, qt.tSpan[i].tS.t0, newSRate, wi.sRate, pr, s);
+	    BUFGROW(numer, nNumer + s->nX, ERMA_NO_MEMORY_SWEEP);
+	    BUFGROW(ratio, nRatio + s->nRatio, ERMA_NO_MEMORY_SWEEP);
+	    memcpy(&numer[nNumer], s->numer, s->nX * sizeof(numer[0]));
+	    memcpy(&ratio[nRatio], s->ratio, s->nRatio * sizeof(ratio[0]));
+	    s->numer = (float *)nNumer;		//offsets for now
+	    s->ratio = (float *)nRatio;
+	    nNumer += s->nX;
+	    nRatio += s->nRatio;
+	}
+	for (int32 i = 0; i < nSig; i++) {
+	    sig[i].numer = &numer[(size_t)sig[i].numer];
+	    sig[i].ratio = &ratio[(size_t)sig[i].ratio];
+	}
+	double t1 = nowSec();
+
+	/* Find this file's labels, if any. */
+	int32 nLab = 0;
+	float *lab = haveLabels ? fileLabels(&sl, files[f], &nLab) : NULL;
+	nLabels += nLab;
+
+	/* Run the grid on the cached signals. */
+	pthread_t tid[NUM_OF(st)];
+	int started[NUM_OF(st)];
+	for (int32 t = 0; t < nThreads; t++) {
+	    st[t].sig = sig;
+	    st[t].nSig = nSig;
+	    st[t].useLabels = haveLabels;
+	    st[t].lab = lab;
+	    st[t].nLab = nLab;
+	    started[t] = !pthread_create(&tid[t], NULL, sweepThread, &st[t]);
+	    if (!started[t])
+		sweepThread(&st[t]);	//couldn't make a thread; do it here
+	}
+	for (int32 t = 0; t < nThreads; t++)
+	    if (started[t])
+		pthread_join(tid[t], NULL);
+	tFilt += t1 - t0;
+	tFind += nowSec() - t1;
+	nFiles++;
+	wisprCleanup(&wi);
+    }
+
+    /* Write the results. */
+    fprintf(fp, "powerThresh,ratioThresh,refractoryT,peakNbdT,nClicks");
+    if (haveLabels)
+	fprintf(fp, ",nLabels,nMatched,precision,recall");
+    fprintf(fp, "\n");
+    for (int32 k = 0; k < nPts; k++) {
+	SWEEPPOINT *pt = &pts[k];
+	fprintf(fp, "%g,%g,%g,%g,%lld", pt->powerThresh, pt->ratioThresh,
+		pt->refractoryT, pt->peakNbdT, (long long)pt->nClicks);
+	if (haveLabels)
+	    fprintf(fp, ",%lld,%lld,%.4f,%.4f", (long long)nLabels,
+		    (long long)pt->nMatched,
+		    pt->nClicks ? (double)pt->nMatched / pt->nClicks : 0.0,
+		    nLabels ? (double)pt->nMatched / nLabels : 0.0);
+	fprintf(fp, "\n");
+    }
+    fclose(fp);
+    printf("ermaSweep: %d files, %.3f s filtering, %.3f s for %d grid points;"
+	   " results in %s\n", nFiles, tFilt, tFind, nPts, path);
+    return 0;
+}
+
+
+/* Report how much the energy gate (see gateSpan in ermaNew.c) speeds up ERMA,
+ * and how many clicks it loses, for each of the gateThresh values given by
+ * sweep.gateThresh in rpi.cnf (default 2, 4, 8). It's run as
+ *
+ *		ErmaMain -gatereport [soundfile ...]
+ *
+ * Each file is read and its quiet times found once; then the profile picked
+ * by sweep.profile is run on it without the gate and with each gate setting.
+ * Recall is measured against the labels in sweep.labels if there are any, or
+ * else against the detections made without the gate. The results go to
+ * sweep.gateOutFile (default gate.csv) in outDir. Arguments are as for
+ * ermaSweep.
+ */
+int ermaGateReport(char **files, ERMACONFIG *ec, ERMAPARAMS *ep,
+		   ERMAPROFILE *prof, int32 nProf, char *baseDir)
+{
+    ERMAPROFILE *pr = sweepProfile(ec, prof, nProf);
+    if (pr == NULL)
+	return ERMA_SWEEP_BAD_PROFILE;
+
+    /* The gate settings; the first one is no gate. */
+    static float g[MAX_SWEEP_VALS + 1] = { 0, 2, 4, 8 };
+    int32 nG = ermaGetFloatArray(ec, "sweep.gateThresh", &g[1],
+				 MAX_SWEEP_VALS) + 1;
+    if (nG == 1)
+	nG = 4;
+    static double sec[MAX_SWEEP_VALS + 1];
+    static int64 nIn[MAX_SWEEP_VALS + 1], nPassed[MAX_SWEEP_VALS + 1];
+    static int64 nClicks[MAX_SWEEP_VALS + 1], nMatched[MAX_SWEEP_VALS + 1];
+
+    SWEEPLABELS sl;
+    int haveLabels = sweepLabels(ec, baseDir, &sl);
+    float tolS = 0.005;
+    ermaGetFloat(ec, "sweep.matchTolS", &tolS);
+    char *outName = "gate.csv";
+    ermaGetString(ec, "sweep.gateOutFile", &outName);
+    char path[256];				//opened now; see ermaSweep
+    snprintf(path, sizeof(path), "%s/%s/%s", baseDir, ep->outDir, outName);
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+	printf("ermaGateReport: can't write %s\n", path);
+	return ERMA_SWEEP_CANT_WRITE;
+    }
+
+    ERMAPARAMS qep = *ep;		//see ermaSweep
+    qep.pctFileName = "sweep_percentiles";
+    ermaFiltPrep(ep);
+
+    static float *snd = NULL, *ref = NULL, *det = NULL;
+    static size_t sndSize = 0, refSize = 0, detSize = 0;
+    QUIETTIMES qt;
+    initQUIETTIMES(&qt);
+    int64 nRef = 0;
+    for (int32 f = 0; files[f] != NULL; f++) {
+	WISPRINFO wi;
+	wisprInitWISPRINFO(&wi);
+	if (!wisprReadHeader(&wi, files[f]))
+	    continue;
+	printf("#%d ermaGateReport: %s\n", f + 1, files[f]);
+	void *raw = wisprReadRaw(&wi);
+	resetQuietTimes(&qt);
+	findQuietTimesRaw(raw, &wi, &qep, &qt, baseDir);
+	decodeQuietTimes(raw, &wi, &qt, &snd, &sndSize);
+
+	int32 nLab = 0;
+	float *lab = haveLabels ? fileLabels(&sl, files[f], &nLab) : NULL;
+	for (int32 k = 0; k < nG; k++) {
+	    ERMAPARAMS gep = *ep;
+	    gep.gateThresh = g[k];
+	    int64 in0, passed0, in1, passed1;
+	    ermaGateGetStats(&in0, &passed0);
+	    double t0 = nowSec();
+	    ermaSegments(snd, &wi, &gep, &qt, pr, 1);
+	    sec[k] += nowSec() - t0;
+	    ermaGateGetStats(&in1, &passed1);
+	    nIn[k] += in1 - in0;
+	    nPassed[k] += passed1 - passed0;
+
+	    FILECLICKS *fc = &pr->fileC;
+	    if (k == 0 && !haveLabels) {
+		//No labels, so the ungated detections are the reference.
+		BUFGROW(ref, MAX(1, fc->n), ERMA_NO_MEMORY_SWEEP);
+		memcpy(ref, fc->timeS, fc->n * sizeof(ref[0]));
+		qsort(ref, fc->n, sizeof(ref[0]), cmpFloat);
+		lab = ref;
+		nLab = fc->n;
+	    }
+	    nClicks[k] += fc->n;
+	    nMatched[k] += matchClicks(fc->timeS, fc->n, lab, nLab, tolS,
+				       &det, &detSize);
+	}
+	nRef += nLab;
+	wisprCleanup(&wi);
+    }
+
+    fprintf(fp, "gateThresh,passedFrac,ermaSec,speedup,nClicks,%s,nMatched,"
+	    "recall,precision\n", haveLabels ? "nLabels" : "nUngated");
+    for (int32 k = 0; k < nG; k++)
+	fprintf(fp, "%g,%.4f,%.3f,%.2f,%lld,%lld,%lld,%.4f,%.4f\n", g[k],
+		nIn[k] ? (double)nPassed[k] / nIn[k] : 0.0, sec[k],
+		sec[k] > 0 ? sec[0] / sec[k] : 0.0, (long long)nClicks[k],
+		(long long)nRef, (long long)nMatched[k],
+		nRef ? (double)nMatched[k] / nRef : 0.0,
+		nClicks[k] ? (double)nMatched[k] / nClicks[k] : 0.0);
+    fclose(fp);
+    printf("ermaGateReport: results in %s\n", path);
+    return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef _ERMASWEEP_H_
+#define _ERMASWEEP_H_
+
+int ermaSweep(char **files, ERMACONFIG *ec, ERMAPARAMS *ep,
+	      ERMAPROFILE *prof, int32 nProf, char *baseDir);
+int ermaGateReport(char **files, ERMACONFIG *ec, ERMAPARAMS *ep,
+		   ERMAPROFILE *prof, int32 nProf, char *baseDir);
+
+#endif	/* _ERMASWEEP_H_ */
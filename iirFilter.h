@@ -8,8 +8,9 @@ typedef struct {
     float *B1, *A1;	/* filter coefficients prepared by initIirFilter */
 } IIRFILTER;
 
-/* These are the three filters used by ERMA */
-extern IIRFILTER downsampleFilter, numerFilter, denomFilter;
+/* This is the downsampling filter used by ERMA. The numerator and denominator
+ * filters are in each profile's ERMAFILT (see ermaFilt.h). */
+extern IIRFILTER downsampleFilter;
 
 
 int initIirFilter(IIRFILTER *ef,	/* in (ef->A,B) and out (ef->A1,B1) */
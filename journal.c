@@ -0,0 +1,326 @@
+
+#include "erma.h"
+
+/* The bookkeeping journal. See journal.h for what it's for and its format.
+ * If it's not open (journalOpen wasn't called, or the journal file name is
+ * ""), records are carried out on their files right away instead.
+ */
+
+static int jfd = -1;			//the journal file
+static char jPath[256];
+static uint8_t *pend = NULL;		//records not yet written to the journal
+static size_t pendSize = 0, nPend = 0;
+static int32 syncFiles = 1;		//fsync every this many journalMarks...
+static float syncS = 0;			//...or this many seconds
+static int32 nSinceSync = 0;
+static double lastSync = 0;
+
+/* A record, as read back from the journal. */
+typedef struct {
+    int type;
+    char target[256];
+    uint8_t *data;
+    uint32 n;
+} JREC;
+
+static void compact(void);
+
+
+/* Append n bytes of data to the file target right away. Return 0 if it
+ * worked. */
+static int applyAppend(char *target, void *data, size_t n)
+{
+    FILE *fp = fopen(target, "a");
+    if (fp == NULL)
+	return 1;
+    int bad = (fwrite(data, 1, n, fp) != n);
+    bad |= (fclose(fp) != 0);
+    return bad;
+}
+
+
+/* Replace the file target with n bytes of data right away. It's written to a
+ * temporary file, which is flushed to the disk and renamed to replace the real
+ * one, so a power cut leaves either the old file or the new one. Return 0 if
+ * it worked. */
+static int applyReplace(char *target, void *data, size_t n)
+{
+    char tmpPath[strlen(target) + 5];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", target);
+    FILE *fp = fopen(tmpPath, "w");
+    int bad = (fp == NULL);
+    if (!bad) {
+	bad = (fwrite(data, 1, n, fp) != n);
+	bad |= (fflush(fp) != 0 || fsync(fileno(fp)) != 0);
+	bad |= (fclose(fp) != 0);
+    }
+    return bad || rename(tmpPath, target);
+}
+
+
+static void addRecord(int type, char *target, void *data, size_t n)
+{
+    uint16 pathLen = strlen(target);
+    uint32 dataLen = n;
+    size_t len = 1 + 2 + 4 + pathLen + dataLen + 4;
+
+    BUFGROW(pend, nPend + len, ERMA_NO_MEMORY_JOURNAL);
+    uint8_t *p = pend + nPend;
+    p[0] = type;
+    memcpy(p + 1, &pathLen, 2);
+    memcpy(p + 3, &dataLen, 4);
+    memcpy(p + 7, target, pathLen);
+    memcpy(p + 7 + pathLen, data, dataLen);
+    uint32 check = fnv1a(p, len - 4);
+    memcpy(p + len - 4, &check, 4);
+    nPend += len;
+}
+
+
+/* Write all n bytes at p to fd. Return 0 if it worked. */
+static int writeAll(int fd, void *p, size_t n)
+{
+    while (n > 0) {
+	ssize_t k = write(fd, p, n);
+	if (k <= 0)
+	    return 1;
+	p = (char *)p + k;
+	n -= k;
+    }
+    return 0;
+}
+
+
+/* Write the saved-up records to the journal. */
+static int flushPending(void)
+{
+    int bad = writeAll(jfd, pend, nPend);
+    nPend = 0;
+    if (bad)
+	fprintf(stderr, "Can't write to journal %s\n", jPath);
+    return bad;
+}
+
+
+/* Open the journal in path, first compacting it if the last run left anything
+ * in it. It's fsync'ed every syncFiles files or syncS seconds, whichever comes
+ * first. If path is "", there's no journal.
+ */
+void journalOpen(char *path, int32 syncFilesArg, float syncSArg)
+{
+    if (path[0] == '\0')
+	return;
+    snprintf(jPath, sizeof(jPath), "%s", path);
+    jfd = open(jPath, O_RDWR | O_CREAT | O_APPEND, 0666);
+    if (jfd < 0) {
+	fprintf(stderr, "Can't open journal %s; writing files directly\n",
+		jPath);
+	return;
+    }
+    syncFiles = MAX(1, syncFilesArg);
+    syncS = syncSArg;
+    compact();
+    nSinceSync = 0;
+    lastSync = nowSec();
+}
+
+
+/* Append n bytes of data to the file target, by way of the journal. */
+void journalAppend(char *target, void *data, size_t n)
+{
+    if (jfd < 0) {
+	if (applyAppend(target, data, n))
+	    fprintf(stderr, "Can't append to %s\n", target);
+    } else
+	addRecord(JREC_APPEND, target, data, n);
+}
+
+
+/* Replace the contents of the file target with n bytes of data, by way of the
+ * journal. */
+void journalReplace(char *target, void *data, size_t n)
+{
+    if (jfd < 0) {
+	if (applyReplace(target, data, n))
+	    fprintf(stderr, "Can't write %s\n", target);
+    } else
+	addRecord(JREC_REPLACE, target, data, n);
+}
+
+
+/* Write the records saved up so far to the journal (one write), and fsync it
+ * if it's time. Call this at each file boundary.
+ */
+void journalMark(void)
+{
+    if (jfd < 0 || nPend == 0)
+	return;
+    flushPending();
+    if (++nSinceSync >= syncFiles || nowSec() - lastSync >= syncS) {
+	if (fsync(jfd) != 0)
+	    fprintf(stderr, "Can't sync journal %s\n", jPath);
+	nSinceSync = 0;
+	lastSync = nowSec();
+    }
+}
+
+
+/* Write any records not yet written to the journal and fsync it, without
+ * compacting it; the next journalOpen does that. Call this in place of
+ * journalClose when there's no time to spare (a fast quit). */
+void journalSync(void)
+{
+    if (jfd < 0)
+	return;
+    if (nPend > 0)
+	flushPending();
+    if (fsync(jfd) != 0)
+	fprintf(stderr, "Can't sync journal %s\n", jPath);
+}
+
+
+/* Compact the journal and close it. Call this when done processing. */
+void journalClose(void)
+{
+    if (jfd < 0)
+	return;
+    compact();
+    close(jfd);
+    jfd = -1;
+}
+
+
+/* Read the records in buf, which has n bytes, into *pRec, stopping at the
+ * first bad one, and put the number of bytes they take up in *pUsed. Return
+ * the number of records. */
+static int32 parseRecords(uint8_t *buf, size_t n, JREC **pRec, size_t *pRecSize,
+			  size_t *pUsed)
+{
+    int32 nRec = 0;
+    size_t pos = 0;
+    uint16 pathLen;
+    uint32 dataLen, check;
+
+    while (pos + 7 <= n) {
+	uint8_t *p = buf + pos;
+	memcpy(&pathLen, p + 1, 2);
+	memcpy(&dataLen, p + 3, 4);
+	size_t len = 1 + 2 + 4 + (size_t)pathLen + dataLen + 4;
+	if (pos + len > n || pathLen >= sizeof((*pRec)->target))
+	    break;
+	memcpy(&check, p + len - 4, 4);
+	if (check != fnv1a(p, len - 4) || (p[0] != JREC_APPEND &&
+				      p[0] != JREC_REPLACE && p[0] != JREC_SIZE))
+	    break;
+	BUFGROW(*pRec, nRec + 1, ERMA_NO_MEMORY_JOURNAL);
+	JREC *r = &(*pRec)[nRec++];
+	r->type = p[0];
+	memcpy(r->target, p + 7, pathLen);
+	r->target[pathLen] = '\0';
+	r->data = p + 7 + pathLen;
+	r->n = dataLen;
+	pos += len;
+    }
+    *pUsed = pos;
+    return nRec;
+}
+
+
+/* Return 1 if the length of the file appended to by record i of the nRec in
+ * rec is already noted, by a JREC_SIZE record for it or by the one noted for
+ * an earlier record appending to it. */
+static int sizeNoted(JREC *rec, int32 nRec, int32 i)
+{
+    for (int32 j = 0; j < nRec; j++)
+	if ((rec[j].type == JREC_SIZE || (rec[j].type == JREC_APPEND && j < i))
+	    && !strcmp(rec[j].target, rec[i].target))
+	    return 1;
+    return 0;
+}
+
+
+/* Carry out the records in the journal (and any not yet written to it) on
+ * their files, and empty it. Appending isn't something that can safely be
+ * done twice, so before doing any, the length of each file to be appended to
+ * is noted in the journal; if the power goes off part way through, the next
+ * compaction cuts the files back to those lengths and starts over.
+ */
+static void compact(void)
+{
+    static uint8_t *buf = NULL;
+    static size_t bufSize = 0;
+    static JREC *rec = NULL;
+    static size_t recSize = 0;
+    static FILE **fps = NULL;		//appended-to files, one per record
+    static size_t fpsSize = 0;
+
+    if (nPend > 0 && flushPending())
+	return;
+    struct stat st;
+    if (fstat(jfd, &st) != 0 || st.st_size == 0)
+	return;
+    BUFGROW(buf, st.st_size, ERMA_NO_MEMORY_JOURNAL);
+    if (pread(jfd, buf, st.st_size, 0) != st.st_size) {
+	fprintf(stderr, "Can't read journal %s\n", jPath);
+	return;
+    }
+    size_t used, jLen = st.st_size;
+    int32 nRec = parseRecords(buf, jLen, &rec, &recSize, &used);
+
+    /* If a compaction was cut short, put the files it appended to back to the
+     * lengths it noted. Then note the lengths of any other files to be
+     * appended to. */
+    for (int32 i = 0; i < nRec; i++)
+	if (rec[i].type == JREC_SIZE) {
+	    int64 len;
+	    memcpy(&len, rec[i].data, sizeof(len));
+	    if (truncate(rec[i].target, len) != 0 && len > 0)
+		fprintf(stderr, "Can't restore %s\n", rec[i].target);
+	}
+    for (int32 i = 0; i < nRec; i++) {
+	if (rec[i].type != JREC_APPEND || sizeNoted(rec, nRec, i))
+	    continue;
+	int64 len = stat(rec[i].target, &st) ? 0 : st.st_size;
+	addRecord(JREC_SIZE, rec[i].target, &len, sizeof(len));
+    }
+    //Cut off anything half-written first, so these can be read back.
+    if ((used < jLen || nPend > 0)
+	&& (ftruncate(jfd, used) != 0 || flushPending() || fsync(jfd) != 0))
+	return;
+
+    /* Carry out the records. Each file appended to is opened just once. */
+    BUFGROW(fps, MAX(1, nRec), ERMA_NO_MEMORY_JOURNAL);
+    int bad = 0;
+    for (int32 i = 0; i < nRec; i++) {
+	JREC *r = &rec[i];
+	fps[i] = NULL;
+	if (r->type == JREC_REPLACE)
+	    bad |= applyReplace(r->target, r->data, r->n);
+	else if (r->type == JREC_APPEND) {
+	    int32 j = 0;
+	    while (j < i && (fps[j] == NULL || strcmp(rec[j].target, r->target)))
+		j++;
+	    FILE *fp = (j < i) ? fps[j] : fopen(r->target, "a");
+	    if (fp == NULL) {
+		fprintf(stderr, "Can't append to %s\n", r->target);
+		bad = 1;			//keep the journal to try again
+		continue;
+	    }
+	    if (j == i)
+		fps[i] = fp;
+	    bad |= (fwrite(r->data, 1, r->n, fp) != r->n);
+	}
+    }
+    for (int32 i = 0; i < nRec; i++)
+	if (fps[i] != NULL) {
+	    bad |= (fflush(fps[i]) != 0 || fsync(fileno(fps[i])) != 0);
+	    bad |= (fclose(fps[i]) != 0);
+	}
+
+    /* Empty the journal. If something went wrong, it's left as is, to try
+     * again next time. */
+    if (bad)
+	fprintf(stderr, "Trouble compacting journal %s\n", jPath);
+    else if (ftruncate(jfd, 0) != 0 || fsync(jfd) != 0)
+	fprintf(stderr, "Can't empty journal %s\n", jPath);
+}
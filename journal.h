@@ -0,0 +1,33 @@
+#ifndef _JOURNAL_H_
+#define _JOURNAL_H_
+
+/* The journal is one file that ERMA's bookkeeping goes into while it runs --
+ * the files_processed marks, the all_dets lines, and the noise percentiles --
+ * in place of each of those being opened and written on its own, many times
+ * per run. Each record says what to do to which file: append some bytes to
+ * it, or replace its contents. At the end of the run (or at the start of the
+ * next, if a run didn't get to the end) the journal is compacted: its records
+ * are carried out on the real files, and it's emptied.
+ *
+ * Records are saved up and written to the journal in one go each time
+ * journalMark is called, i.e., just before each file is processed, so the
+ * file's files_processed mark is out of ERMA's hands before processing starts,
+ * as it always has been. The journal is fsync'ed once per batch of files,
+ * rather than not at all.
+ *
+ * A record is a type byte, the uint16 length of the file name, the uint32
+ * length of the data, the name, the data, and a checksum of all that, so a
+ * record half-written when the power went off is seen as the end.
+ */
+#define JREC_APPEND	'A'	//append the data to the file
+#define JREC_REPLACE	'R'	//replace the file with the data
+#define JREC_SIZE	'S'	//compaction under way; file was this long
+
+void journalOpen(char *path, int32 syncFiles, float syncS);
+void journalAppend(char *target, void *data, size_t n);
+void journalReplace(char *target, void *data, size_t n);
+void journalMark(void);
+void journalSync(void);
+void journalClose(void);
+
+#endif	/* _JOURNAL_H_ */
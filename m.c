@@ -0,0 +1,11 @@
+int main(void) {
+    STRSET s; initSTRSET(&s);
+    strSetAdd(&s, "a.dat"); strSetAdd(&s, "b.dat"); strSetAdd(&s, "c.dat");
+    for (int k = 0; k < 2; k++) {
+	char **f = getNewFiles(&s, "t", "[0-9]*/*.dat", "t/state");
+	for (int i = 0; f[i]; i++) printf("  %s\n", f[i]);
+	if (k == 0) { system("touch t/170103/d.dat t/170102/e.dat; touch -d '1 hour ago' t/17010*"); }
+    }
+    system("cat t/state");
+    return 0;
+}
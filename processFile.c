@@ -25,10 +25,23 @@
 static float *snd = NULL;	/* the sound signal for this file */
 static size_t sndSize = 0;	/* for bufgrow */
 static QUIETTIMES quietT;	/* (start,stop) times when glider motors off */
-static ENCOUNTERS enc;		/* whale encounter times */
-static FILECLICKS fileC;	/* clicks found in one file */
 
-void processFile(char *inPath, char *outPath, ERMAPARAMS *ep, ALLCLICKS *allC,
+static void batchSegments(WISPRINFO *wi, ERMAPARAMS *ep, ERMAPROFILE *prof,
+			  int32 nProf, char *baseDir);
+static void onlineSegments(WISPRINFO *wi, ERMAPARAMS *ep, ERMAPROFILE *prof,
+			   int32 nProf, char *baseDir);
+
+/* Time spent in each stage of processing, summed over all files this run. See
+ * printStageTimes() below. */
+static double tRead = 0, tQuiet = 0, tErma = 0, tSave = 0;
+static int32 nFilesTimed = 0;
+
+/* Process one input file: read it, find its quiet times, and run each of the
+ * nProf detector profiles in prof on them. Each profile's clicks are appended
+ * to its allC and saved to its allDetsPath and/or allDetsBinPath. ep has the
+ * params shared by all profiles.
+ */
+void processFile(char *inPath, ERMAPARAMS *ep, ERMAPROFILE *prof, int32 nProf,
 		 double *pTMinE, double *pTMaxE, char *baseDir)
 {
     static int firstTime = 1;		/* controls initialization */
@@ -36,9 +49,10 @@ void processFile(char *inPath, char *outPath, ERMAPARAMS *ep, ALLCLICKS *allC,
 	firstTime = 0;
 	ermaFiltPrep(ep);
 	initQUIETTIMES(&quietT);
-	initFILECLICKS(&fileC);
-	initENCOUNTERS(&enc);
-	printf("processFile: file with all clicks: %s\n", outPath);
+	for (int32 p = 0; p < nProf; p++)
+	    printf("processFile: file with all clicks: %s\n",
+		   prof[p].ep.allDetsBinary == 2 ? prof[p].allDetsBinPath
+		   : prof[p].allDetsPath);
     }
 
     WISPRINFO wi;
@@ -53,32 +67,152 @@ void processFile(char *inPath, char *outPath, ERMAPARAMS *ep, ALLCLICKS *allC,
     *pTMinE = MIN(*pTMinE, wi.timeE);
     *pTMaxE = MAX(*pTMaxE, wi.timeE + wi.nSamp / wi.sRate);
     
-    /* Ensure the directory for the output file exists, creating it if not */
+    /* Ensure the directory for the output files exists, creating it if not */
     char dirPath[256];
-    pathDir(dirPath, outPath);		/* get dir name sans file part */
-    if (!dirExists(dirPath)) {
-	if (mkdir(dirPath, 0777) != 0)
-	    return;		/* can't create dir for output file! */
+    for (int32 p = 0; p < nProf; p++) {
+	pathDir(dirPath, prof[p].allDetsPath);	/* get dir name sans file part */
+	if (!dirExists(dirPath)) {
+	    if (mkdir(dirPath, 0777) != 0)
+		return;		/* can't create dir for output file! */
+	}
     }
 
-    /* Read sound samples, convert to float */
-    wisprReadSamples(&wi, &snd, &sndSize);
+    /* Read the samples, find the quiet times, and run ERMA (in ermaNew.c) on
+     * them, getting click times in this file in each profile's fileC. */
+    if (ep->ns_onlineChunkS > 0)
+	onlineSegments(&wi, ep, prof, nProf, baseDir);
+    else
+	batchSegments(&wi, ep, prof, nProf, baseDir);
+    double t3 = nowSec();
+
+    /* For each profile, append the clicks to its allC as Epoch times, save
+     * them, and bring its encounters up to date, so they're ready to save at
+     * any time -- e.g., when WISPR asks for a fast quit. findEncounters only
+     * looks at the new clicks and the blocks since the last file. */
+    for (int32 p = 0; p < nProf; p++) {
+	int32 startClickNo = prof[p].allC.n;
+	appendClicks(&prof[p].allC, &prof[p].fileC, wi.timeE);
+	if (prof[p].ep.allDetsBinary != 2)
+	    saveNewClicks(&prof[p].allC, startClickNo, wi.timeE,
+			  prof[p].allDetsPath, inPath);
+	allDetsBinAppend(prof[p].allDetsBinPath, inPath, &prof[p].fileC,
+			 wi.timeE, prof[p].ep.allDetsSpectra);
+	clickLogAppend(prof[p].clickLogPath, inPath, &prof[p].fileC, wi.timeE);
+	findEncounters(&prof[p].allC, &prof[p].ep, &prof[p].encState,
+		       &prof[p].enc);
+    }
+    double t4 = nowSec();
+
+    tSave += t4 - t3;
+    nFilesTimed++;
+
+    wisprCleanup(&wi);
+}
+
+
+/* Read the whole file described by wi, find its quiet times, and run the ERMA
+ * detectors on them. Results are in each profile's fileC.
+ */
+static void batchSegments(WISPRINFO *wi, ERMAPARAMS *ep, ERMAPROFILE *prof,
+			  int32 nProf, char *baseDir)
+{
+    /* Read sound samples */
+    double t0 = nowSec();
+    void *raw = wisprReadRaw(wi);
+    double t1 = nowSec();
 
-    /* Find the useful data spans */
+    /* Find the useful data spans, and convert just them to float */
     resetQuietTimes(&quietT);
-    findQuietTimes(snd, wi.nSamp, wi.sRate, ep, &quietT, baseDir);
+    findQuietTimesRaw(raw, wi, ep, &quietT, baseDir);
+    decodeQuietTimes(raw, wi, &quietT, &snd, &sndSize);
     #ifdef PRINT_QUIET_TIMES
     printQuietTimes(&quietT);		/* DEBUG */
     #endif
+    double t2 = nowSec();
 
-    /* Run ERMA (in ermaNew.c), getting click times in this file in
-     * fileC. Append these to allC as Epoch times. */
-    int32 startClickNo = allC->n;
-    ermaSegments(snd, &wi, ep, &quietT, &fileC);
-    appendClicks(allC, &fileC, wi.timeE);
+    /* Run ERMA (in ermaNew.c), getting click times in this file in each
+     * profile's fileC. */
+    ermaSegments(snd, wi, ep, &quietT, prof, nProf);
+    double t3 = nowSec();
 
-    /* Save all detected clicks. */
-    saveNewClicks(allC, startClickNo, wi.timeE, outPath, inPath);
+    tRead += t1 - t0;
+    tQuiet += t2 - t1;
+    tErma += t3 - t2;
+}
 
-    wisprCleanup(&wi);
+
+/* Like batchSegments, but with ep->ns_onlineChunkS > 0: the file is read that
+ * many seconds at a time, and the quiet times are found as it goes by a
+ * QUIETSTREAM. Each piece of quiet time is handed to ERMA as soon as it's sure
+ * to be quiet, without waiting for the rest of the file. ERMA carries on from
+ * one piece to the next, filters, signals, and click search and all (see
+ * ermaSignals), so no click is lost at a boundary between pieces.
+ */
+static void onlineSegments(WISPRINFO *wi, ERMAPARAMS *ep, ERMAPROFILE *prof,
+			   int32 nProf, char *baseDir)
+{
+    static QUIETSTREAM qs;
+    static QUIETTIMES newT;	/* the pieces found in one chunk */
+    static int firstTime = 1;
+    if (firstTime) {
+	firstTime = 0;
+	initQUIETTIMES(&newT);
+    }
+
+    void *raw = wisprRawBuffer(wi);
+    size_t chunk = MAX(1, round(ep->ns_onlineChunkS * wi->sRate));
+    int newFile = 1;			/* no quiet time handed over yet */
+    for (int32 p = 0; p < nProf; p++)
+	resetFILECLICKS(&prof[p].fileC);
+    quietStreamStart(&qs, wi->sRate, ep, baseDir);
+    for (size_t s0 = 0; s0 < wi->nSamp; s0 += chunk) {
+	double t0 = nowSec();
+	size_t n = MIN(chunk, wi->nSamp - s0);
+	wisprReadRawPart(wi, raw, s0, n);
+	double t1 = nowSec();
+
+	resetQuietTimes(&newT);
+	quietStreamRaw(&qs, raw, wi, s0 + n, &newT);
+	if (s0 + n == wi->nSamp)
+	    quietStreamEnd(&qs, &newT);
+	#ifdef PRINT_QUIET_TIMES
+	printQuietTimes(&newT);		/* DEBUG */
+	#endif
+	decodeQuietTimes(raw, wi, &newT, &snd, &sndSize);
+	double t2 = nowSec();
+
+	ermaMoreSegments(snd, wi, ep, &newT, newFile, prof, nProf);
+	newFile = (newFile && newT.n == 0);
+	double t3 = nowSec();
+
+	tRead += t1 - t0;
+	tQuiet += t2 - t1;
+	tErma += t3 - t2;
+    }
+}
+
+
+/* Print how long each stage of processing took, summed over all the files
+ * processed so far. The quiet-time stage includes converting the samples in
+ * quiet times to float. The ERMA time includes the time for click spectra,
+ * which is also shown separately, per click.
+ */
+void printStageTimes(void)
+{
+    double specSec;
+    int32 nSpec;
+
+    clickSpecGetTimes(&specSec, &nSpec);
+    printf("Stage timings for %d file(s), s:\n", nFilesTimed);
+    printf("    read      %8.3f\n", tRead);
+    printf("    quiet     %8.3f\n", tQuiet);
+    printf("    erma      %8.3f\n", tErma);
+    printf("    spectra   %8.3f  (%d clicks, %.1f us/click)\n", specSec, nSpec,
+	   nSpec > 0 ? specSec / nSpec * 1e6 : 0.0);
+    int64 nGateIn, nGatePassed;
+    ermaGateGetStats(&nGateIn, &nGatePassed);
+    if (nGatePassed < nGateIn)
+	printf("    (energy gate passed %.1f%% of quiet-time samples)\n",
+	       100.0 * nGatePassed / nGateIn);
+    printf("    save      %8.3f\n", tSave);
 }
@@ -4,7 +4,8 @@
 
 /*#include "ermaConfig.h"*/
 
-void processFile(char *inPath, char *outPath, ERMAPARAMS *ep, ALLCLICKS *allC,
+void processFile(char *inPath, ERMAPARAMS *ep, ERMAPROFILE *prof, int32 nProf,
 		 double *pTMinE, double *pTMaxE, char *baseDir);
+void printStageTimes(void);
 
 #endif    /* _PROCESSFILE_H_ */
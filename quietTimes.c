@@ -2,8 +2,13 @@
 #include "erma.h"
 
 /* defined below */
+static QUIETTIMES *quietFromPower(int32 nBlocks, int32 blockLen, float sRate,
+				  ERMAPARAMS *ep, QUIETTIMES *qt,
+				  char *baseDir);
 void checkQuiet(int64 i0, int64 i1, float blockDurS, int64 blockLen,
 		int32 nBlocks, float sRate, ERMAPARAMS *ep, QUIETTIMES *qt);
+static void loadPcts(ERMAPARAMS *ep, char *baseDir);
+static void notePct(float pct, ERMAPARAMS *ep);
 float getThresh(float *avgPower, size_t nPow, ERMAPARAMS *ep, char *baseDir);
 
 /* This is the threshold when the avgPower vector is empty. It shouldn't ever
@@ -12,6 +17,15 @@ float getThresh(float *avgPower, size_t nPow, ERMAPARAMS *ep, char *baseDir);
  */
 float quietTimesDefaultThresh = 5e8;
 
+/* blockPower sums POW_LANES interleaved streams of samples in float, folding
+ * them into doubles every POW_CHUNK samples so the float sums stay short. */
+#define POW_LANES	8
+#define POW_CHUNK	256	//a multiple of POW_LANES
+
+/* Average power of each noise block, from blockPower or rawBlockPower. */
+static float *avgPower = NULL;
+static size_t avgPowerSize = 0;		/* for bufgrow */
+
 
 void initQUIETTIMES(QUIETTIMES *qt)
 {
@@ -30,6 +44,95 @@ void resetQuietTimes(QUIETTIMES *qt)
 }
 
 
+/* Find the average power of the n samples in x after removing their DC offset
+ * (mean), i.e. their variance. This is done in one pass as
+ *		E[(x-k)^2] - E[x-k]^2
+ * where the shift k is the first sample, which is close enough to the mean
+ * that the subtraction loses little precision. The inner loop works on
+ * POW_LANES independent sums, so the compiler can use SIMD instructions for it.
+ */
+static float blockPower(float *x, int32 n)
+{
+    float k = x[0];
+    double sum = 0.0, sumSq = 0.0;
+    int32 j = 0;
+
+    while (j + POW_LANES <= n) {
+	float s[POW_LANES] = { 0 }, sq[POW_LANES] = { 0 };
+	int32 jEnd = j + MIN(POW_CHUNK, (n - j) / POW_LANES * POW_LANES);
+	for ( ; j < jEnd; j += POW_LANES) {
+	    for (int32 l = 0; l < POW_LANES; l++) {
+		float v = x[j+l] - k;
+		s[l] += v;
+		sq[l] += v * v;
+	    }
+	}
+	for (int32 l = 0; l < POW_LANES; l++) {
+	    sum += s[l];
+	    sumSq += sq[l];
+	}
+    }
+    for ( ; j < n; j++) {
+	double v = x[j] - k;
+	sum += v;
+	sumSq += v * v;
+    }
+    double mean = sum / n;
+    return (float)MAX(0.0, sumSq / n - mean * mean);
+}
+
+
+/* Like blockPower, but for n samples starting at sample sam0 of raw, a buffer
+ * of undecoded samples from wisprReadRaw, using only every step'th one (see
+ * noiseStep). The sums are done in integers, so they're exact, and no shift is
+ * needed.
+ */
+static float rawBlockPower(void *raw, int32 sampleSize, size_t sam0, int32 n,
+			   int32 step)
+{
+    int64 sum = 0, sumSq = 0;
+    int32 m = (n + step - 1) / step;	//# of samples used
+
+    if (sampleSize == 2 && step == 1) {
+	int16 *x = (int16 *)raw + sam0;
+	for (int32 j = 0; j < n; j++) {
+	    sum += x[j];
+	    sumSq += (int32)x[j] * x[j];
+	}
+    } else if (sampleSize == 2) {
+	int16 *x = (int16 *)raw + sam0;
+	for (int32 j = 0; j < n; j += step) {
+	    sum += x[j];
+	    sumSq += (int32)x[j] * x[j];
+	}
+    } else {
+	unsigned char *s = (unsigned char *)raw + sam0 * 3;
+	for (int32 j = 0; j < n; j += step, s += 3 * step) {
+	    int32 v = s[2] << 16 | s[1] << 8 | s[0];
+	    v |= (s[2] & 0x80) ? 0xff000000 : 0;	//sign-extend
+	    sum += v;
+	    sumSq += (int64)v * v;
+	}
+    }
+    double mean = (double)sum / m;
+    return (float)MAX(0.0, (double)sumSq / m - mean * mean);
+}
+
+
+/* The step for rawBlockPower. With ep->ns_decimate, the noise-block
+ * statistics are found from every ep->decim'th sample only, a cheap
+ * decimation with no anti-alias filter; they cost a fraction as much, and
+ * since aliasing folds the power above the new Nyquist frequency back down
+ * rather than losing it, the block powers come out much the same. They're a
+ * little noisier, so the recent pcts are kept in a file of their own (see
+ * loadPcts).
+ */
+static int32 noiseStep(ERMAPARAMS *ep)
+{
+    return ep->ns_decimate ? MAX(1, ep->decim) : 1;
+}
+
+
 /* Given a signal snd, find the sections of time when glider motors aren't
  * running and things are reasonably quiet.
  */
@@ -37,27 +140,45 @@ QUIETTIMES *findQuietTimes(float *snd, size_t nSamp, float sRate,
 			   ERMAPARAMS *ep, QUIETTIMES *qt, char *baseDir)
 {
     int32 blockLen = round(ep->ns_tBlockS * sRate);  /* block len in samples */
-    float blockDurS = blockLen / sRate;		/* block len in s */
     int32 nBlocks = nSamp / blockLen;		/* number of blocks in snd */
-    static float *avgPower = NULL;
-    static size_t avgPowerSize = 0;		/* for bufgrow */
 
     BUFGROW(avgPower, nBlocks, ERMA_NO_MEMORY_AVGPOWER);
-    for (int32 i = 0, p = 0; i < nBlocks; i++, p += blockLen) {
-	/* find DC offset = average of all the samples */
-	double sum = 0.0; /* double, as it's sum of potentially many floats */
-	for (int32 j = p; j < p+blockLen; j++)
-	    sum += (double)snd[j];
-	float avgSam = (float)(sum / (double)blockLen);
-
-	/* Find average power of this block = sum(samples^2)/nSamples */
-	sum = 0.0;
-	for (int32 j = p; j < p+blockLen; j++) {
-	    float val = snd[j] - avgSam;
-	    sum += (double)(val * val);
-	}
-	avgPower[i] = (float)(sum / (double)blockLen);
-    }
+    /* Find the average power of each block with its DC offset removed. */
+    for (int32 i = 0; i < nBlocks; i++)
+	avgPower[i] = blockPower(&snd[(size_t)i * blockLen], blockLen);
+
+    return quietFromPower(nBlocks, blockLen, sRate, ep, qt, baseDir);
+}
+
+
+/* Same as findQuietTimes, but working straight from the undecoded samples in
+ * raw, a buffer from wisprReadRaw. This way the samples in noisy times never
+ * need to be converted to float; see decodeQuietTimes.
+ */
+QUIETTIMES *findQuietTimesRaw(void *raw, WISPRINFO *wi, ERMAPARAMS *ep,
+			      QUIETTIMES *qt, char *baseDir)
+{
+    int32 blockLen = round(ep->ns_tBlockS * wi->sRate);
+    int32 nBlocks = wi->nSamp / blockLen;
+
+    int32 step = noiseStep(ep);
+
+    BUFGROW(avgPower, nBlocks, ERMA_NO_MEMORY_AVGPOWER);
+    for (int32 i = 0; i < nBlocks; i++)
+	avgPower[i] = rawBlockPower(raw, wi->sampleSize,
+				    (size_t)i * blockLen, blockLen, step);
+
+    return quietFromPower(nBlocks, blockLen, wi->sRate, ep, qt, baseDir);
+}
+
+
+/* The rest of findQuietTimes, once the nBlocks values in avgPower are set. */
+static QUIETTIMES *quietFromPower(int32 nBlocks, int32 blockLen, float sRate,
+				  ERMAPARAMS *ep, QUIETTIMES *qt,
+				  char *baseDir)
+{
+    float blockDurS = blockLen / sRate;		/* block len in s */
+
 #ifdef DEBUG_NOISE_POWER
     printSignalToFile(avgPower, nBlocks, "temp-avgPower.csv");
 #endif
@@ -95,6 +216,29 @@ QUIETTIMES *findQuietTimes(float *snd, size_t nSamp, float sRate,
 	checkQuiet(quietStart, nBlocks - (n>0 ? n+padBlock : 0) + 1,
 		   blockDurS, blockLen, nBlocks, sRate, ep, qt);
     }
+    return qt;
+}
+
+
+/* Decode to float just the samples in the quiet times in qt, putting them
+ * end-to-end in *pSnd (whose size for bufgrow is *pSndSize). raw is a buffer
+ * from wisprReadRaw. Returns the number of samples decoded.
+ */
+size_t decodeQuietTimes(void *raw, WISPRINFO *wi, QUIETTIMES *qt,
+			float **pSnd, size_t *pSndSize)
+{
+    size_t n = 0;
+    for (int32 i = 0; i < qt->n; i++)
+	n += qt->tSpan[i].sam1 - qt->tSpan[i].sam0;
+    BUFGROW(*pSnd, MAX(n, 1), ERMA_NO_MEMORY_WISPR_PSND);
+
+    size_t off = 0;
+    for (int32 i = 0; i < qt->n; i++) {
+	size_t len = qt->tSpan[i].sam1 - qt->tSpan[i].sam0;
+	wisprDecode(&(*pSnd)[off], raw, qt->tSpan[i].sam0, len, wi);
+	off += len;
+    }
+    return n;
 }
 
 
@@ -131,6 +275,57 @@ void printQuietTimes(QUIETTIMES *qt)
 
 
 
+/* The recent ns_pctile values used by getThresh. ring[] has them in the order
+ * they were found, starting at ring[head] (the oldest); sorted[] has the same
+ * values in increasing order, so the median is just its middle element. With
+ * only a dozen or so values, keeping sorted[] up to date by moving elements
+ * over is as quick as anything fancier.
+ */
+static float *ring = NULL, *sorted = NULL;
+static size_t ringSize = 0, sortedSize = 0;
+static int32 nRecent = 0;		//capacity of ring[] and sorted[]
+static int32 nPcts = 0, head = 0;	//# of values in them, oldest in ring[]
+static int32 nSinceSave = 0;		//# of values added since last save
+static char pctPath[256];		//the ep->pctFileName file
+
+
+/* Put val into sorted[], which has n values. */
+static void sortedInsert(float val, int32 n)
+{
+    int32 i = n;
+    while (i > 0 && sorted[i-1] > val) {
+	sorted[i] = sorted[i-1];
+	i--;
+    }
+    sorted[i] = val;
+}
+
+
+/* Take (one copy of) val out of sorted[], which has n values. */
+static void sortedRemove(float val, int32 n)
+{
+    int32 i = 0;
+    while (i < n-1 && sorted[i] != val)
+	i++;
+    memmove(&sorted[i], &sorted[i+1], (n-1 - i) * sizeof(sorted[0]));
+}
+
+
+/* Add a new pct value, dropping the oldest one if there are already nRecent. */
+static void addPct(float pct)
+{
+    if (nPcts == nRecent) {
+	sortedRemove(ring[head], nPcts);
+	ring[head] = pct;
+	head = (head + 1) % nRecent;
+	nPcts--;
+    } else
+	ring[(head + nPcts) % nRecent] = pct;
+    sortedInsert(pct, nPcts);
+    nPcts++;
+}
+
+
 /* Find threshold. If avgPower is above this for an extended period of time,
  * it's evidence that a glider motor is on. This threshold is the median of the
  * 12 most recent 10th-percentile values of avgPower. Only it's not 12, it's
@@ -139,60 +334,297 @@ void printQuietTimes(QUIETTIMES *qt)
  *
  * Also, at the start of processing, we don't have any recent 10th-percentile
  * values. So use the most recent values from the last run, which are stored in
- * ep->pctFileName.
+ * ep->pctFileName (with "-decim" on the end if ep->ns_decimate). That file is
+ * re-written every ep->ns_saveEvery files, and by quietTimesSavePcts when
+ * processing is done.
  */
 float getThresh(float *avgPower, size_t nPow, ERMAPARAMS *ep, char *baseDir)
 {
-    static float *pcts = NULL;
-    static size_t pctsSize = 0;
-    static int nPcts = 0;
-
     if (nPow == 0)
 	return quietTimesDefaultThresh;
+    loadPcts(ep, baseDir);
+
+    /* Calculate the 10th-percentile (or really ep->ns_pctile) value. This
+     * percentile function leaves avgPower as is, so no copy is needed. */
+    notePct(percentileRadix(avgPower, nPow, ep->ns_pctile), ep);
+
+    /* Get the threshold from the median of pcts. This picks the same element
+     * as percentile(pcts, nPcts, 0.5) would. */
+    float median = sorted[(int32)round((nPcts - 1) * 0.5)];
+    return median * ep->ns_medianMult;
+}
 
-    /* Construct pathname of file that has recent 10th-percentile values. */
-    char pctPath[256];
-    snprintf(pctPath, sizeof(pctPath), "%s/%s", baseDir, ep->pctFileName);
 
-    if (pcts == NULL) {
-	//First time. See if there are pcts left over from the last run.
-	BUFGROW(pcts, ep->ns_nRecent, ERMA_NO_MEMORY_GETTHRESH);
-	nPcts = readFloatArray(&pcts, &pctsSize, ep->ns_nRecent, pctPath);
-/*	printf("getThresh: %d pcts from file: ", nPcts);*/
-/*	printFloatArray("", pcts, nPcts);*/
+/* The first time, get the pcts left over from the last run, if any. */
+static void loadPcts(ERMAPARAMS *ep, char *baseDir)
+{
+    if (ring != NULL)
+	return;
+    snprintf(pctPath, sizeof(pctPath), "%s/%s%s", baseDir, ep->pctFileName,
+	     ep->ns_decimate ? "-decim" : "");
+    nRecent = MAX(1, ep->ns_nRecent);
+    BUFGROW(ring, nRecent, ERMA_NO_MEMORY_GETTHRESH);
+    BUFGROW(sorted, nRecent, ERMA_NO_MEMORY_GETTHRESH);
+    nPcts = readFloatArray(&ring, &ringSize, nRecent, pctPath);
+    head = 0;
+    for (int32 i = 0; i < nPcts; i++)
+	sortedInsert(ring[i], i);
+}
+
+
+/* Add a file's pct value to the recent ones, and save them in the pctPath file
+ * every so often.
+ */
+static void notePct(float pct, ERMAPARAMS *ep)
+{
+    addPct(pct);
+    if (++nSinceSave >= ep->ns_saveEvery)
+	quietTimesSavePcts();
+}
+
+
+/* Save the recent pcts values, oldest first, in the ep->pctFileName file for
+ * the next run to start with. This goes by way of the journal (see journal.h),
+ * which replaces the file in a way that doesn't leave it half-written if the
+ * power goes off in the middle. Call this when done processing files.
+ */
+void quietTimesSavePcts(void)
+{
+    static float *buf = NULL;
+    static size_t bufSize = 0;
+
+    if (ring == NULL || nSinceSave == 0)
+	return;
+    BUFGROW(buf, nPcts, ERMA_NO_MEMORY_GETTHRESH);
+    for (int32 i = 0; i < nPcts; i++)
+	buf[i] = ring[(head + i) % nRecent];
+    journalReplace(pctPath, buf, nPcts * sizeof(buf[0]));
+    nSinceSave = 0;
+}
+
+
+/* Return the median of the recent pcts as it will be once est is added by
+ * addPct, without actually adding it.
+ */
+static float medianWith(float est)
+{
+    static float *tmp = NULL;
+    static size_t tmpSize = 0;
+    int dropOldest = (nPcts == nRecent);
+    int32 n = 0;
+
+    BUFGROW(tmp, nRecent + 1, ERMA_NO_MEMORY_GETTHRESH);
+    for (int32 i = 0; i < nPcts; i++) {
+	if (dropOldest && sorted[i] == ring[head])
+	    dropOldest = 0;
+	else
+	    tmp[n++] = sorted[i];
     }
+    int32 i = n++;
+    while (i > 0 && tmp[i-1] > est) {
+	tmp[i] = tmp[i-1];
+	i--;
+    }
+    tmp[i] = est;
+    return tmp[(int32)round((n - 1) * 0.5)];
+}
 
-    /* Calculate the 10th-percentile (or really ep->ns_pctile) value. First make
-     * a copy of avgPower, since percentile() rearranges it. */
-    static float *powCopy = NULL;
-    static size_t powCopySize = 0;
-    BUFGROW(powCopy, nPow, ERMA_NO_MEMORY_GETTHRESH);
-    memcpy(powCopy, avgPower, nPow * sizeof(avgPower[0]));
-    float pct = percentile(powCopy, nPow, ep->ns_pctile);
-    /* Store pct at the end of pcts[]. If pcts is already full, first shift it
-     * left so the oldest value disappears. */
-    if (nPcts == ep->ns_nRecent) {		    //is pcts[] full?
-	for (int i = 0; i < ep->ns_nRecent-1; i++)  //shift pcts left one place
-	    pcts[i] = pcts[i+1];
-	nPcts--;
+
+/******************************* Online version *****************************/
+/* findQuietTimes needs all of a file's noise blocks before it can say where
+ * the quiet times are. A QUIETSTREAM does the same job as the blocks arrive:
+ * call quietStreamStart at the start of a file, quietStreamRaw as samples are
+ * read, and quietStreamEnd at the end. Each call puts any newly found quiet
+ * time into a QUIETTIMES.
+ *
+ * The differences from findQuietTimes are these. First, the file's
+ * ns_pctile'th percentile of block power, which goes into the threshold, is
+ * estimated as the blocks go by with the P^2 algorithm (Jain & Chlamtac 1985,
+ * CACM 28:1076) rather than computed from all of them; the final estimate is
+ * what's kept in the recent pcts. Second, a long quiet time comes out in
+ * pieces: a block can be passed on once it's further back than ns_tConsecS +
+ * ns_padSec, since no noise section found later can reach back that far. The
+ * pieces follow on from each other, so ERMA processes them as one signal (see
+ * ermaContinue and ermaSignals). Third, the threshold is worked out afresh for
+ * each block from the estimate so far (see streamBlock), not once per file.
+ * Only if the threshold were fixed would the pieces add up to exactly the
+ * quiet times findQuietTimes would find; as it is, they can differ a little.
+ */
+
+/* Add x to the P^2 estimate of the p'th percentile in qs. */
+static void p2Add(QUIETSTREAM *qs, float x, float p)
+{
+    float *q = qs->q;			//marker heights
+    double *n = qs->pos, *want = qs->want;	//their actual & desired positions
+
+    if (qs->nObs < 5) {
+	//Until there are 5 values, just keep them in order.
+	int32 i = qs->nObs++;
+	while (i > 0 && q[i-1] > x) {
+	    q[i] = q[i-1];
+	    i--;
+	}
+	q[i] = x;
+	if (qs->nObs == 5) {
+	    for (int32 i = 0; i < 5; i++)
+		n[i] = i + 1;
+	    want[0] = 1;  want[1] = 1 + 2*p;  want[2] = 1 + 4*p;
+	    want[3] = 3 + 2*p;  want[4] = 5;
+	}
+	return;
+    }
+    qs->nObs++;
+
+    /* Find the cell x falls in, extending the end markers if need be. */
+    int32 k;
+    if (x < q[0]) {
+	q[0] = x;
+	k = 0;
+    } else if (x >= q[4]) {
+	q[4] = x;
+	k = 3;
+    } else
+	for (k = 0; x >= q[k+1]; k++)
+	    ;
+    for (int32 i = k + 1; i < 5; i++)
+	n[i] += 1;
+    want[1] += p/2;  want[2] += p;  want[3] += (1+p)/2;  want[4] += 1;
+
+    /* Move the middle markers toward their desired positions, adjusting their
+     * heights with a parabolic fit if it stays in order, else linearly. */
+    for (int32 i = 1; i <= 3; i++) {
+	double d = want[i] - n[i];
+	if ((d >= 1 && n[i+1] - n[i] > 1) || (d <= -1 && n[i-1] - n[i] < -1)) {
+	    int32 s = (d > 0) ? 1 : -1;
+	    double qp = q[i] + s / (n[i+1] - n[i-1]) *
+		((n[i] - n[i-1] + s) * (q[i+1] - q[i]) / (n[i+1] - n[i]) +
+		 (n[i+1] - n[i] - s) * (q[i] - q[i-1]) / (n[i] - n[i-1]));
+	    if (!(q[i-1] < qp && qp < q[i+1]))
+		qp = q[i] + s * (q[i+s] - q[i]) / (n[i+s] - n[i]);
+	    q[i] = qp;
+	    n[i] += s;
+	}
+    }
+}
+
+
+/* Return the P^2 estimate of the p'th percentile in qs. */
+static float p2Get(QUIETSTREAM *qs, float p)
+{
+    if (qs->nObs == 0)
+	return 0.0;
+    if (qs->nObs < 5)
+	return qs->q[(int32)round((qs->nObs - 1) * p)];
+    return qs->q[2];
+}
+
+
+/* Add blocks b0 to b1 (not including b1) to qt as quiet time, or the part of
+ * them that hasn't been added already. This is only done if the whole quiet
+ * section, which is at least this long, is at least ns_minQuietS long. As in
+ * checkQuiet, that check is done before b1 is limited to the blocks seen. A
+ * piece that follows on from the last span in qt is merged into it.
+ */
+static void streamEmit(QUIETSTREAM *qs, int64 b0, int64 b1, QUIETTIMES *qt)
+{
+    if ((b1 - b0) * qs->blockDurS < qs->ep->ns_minQuietS)
+	return;
+    b0 = MAX(MAX(b0, 0), qs->emitted);
+    b1 = MIN(b1, qs->nBlocks);
+    if (b1 <= b0)
+	return;
+
+    if (qt->n > 0 && qt->tSpan[qt->n-1].sam1 == b0 * qs->blockLen) {
+	qt->tSpan[qt->n-1].sam1  = b1 * qs->blockLen;
+	qt->tSpan[qt->n-1].tS.t1 = qt->tSpan[qt->n-1].sam1 / qs->sRate;
+	qs->emitted = b1;
+	return;
+    }
+    BUFGROW(qt->tSpan, qt->n + 1, ERMA_NO_MEMORY_QUIETTIME);
+    qt->tSpan[qt->n].sam0  = b0 * qs->blockLen;
+    qt->tSpan[qt->n].sam1  = b1 * qs->blockLen;
+    qt->tSpan[qt->n].tS.t0 = qt->tSpan[qt->n].sam0 / qs->sRate;
+    qt->tSpan[qt->n].tS.t1 = qt->tSpan[qt->n].sam1 / qs->sRate;
+    qt->n++;
+    qs->emitted = b1;
+}
+
+
+/* Take in the next block, whose average power is pow. This is the loop in
+ * quietFromPower done one step at a time. */
+static void streamBlock(QUIETSTREAM *qs, float pow, QUIETTIMES *qt)
+{
+    ERMAPARAMS *ep = qs->ep;
+
+    p2Add(qs, pow, ep->ns_pctile);
+    float thresh = medianWith(p2Get(qs, ep->ns_pctile)) * ep->ns_medianMult;
+
+    int64 i = qs->nBlocks++;
+    if (pow >= thresh) {
+	qs->nNoise++;
+	if (qs->nNoise == qs->minConsec && !qs->inNoise) {
+	    //A noise section long enough to count; end the quiet time.
+	    qs->inNoise = 1;
+	    streamEmit(qs, qs->quietStart, i - qs->nNoise + 1 - qs->padBlock, qt);
+	}
+    } else {
+	if (qs->inNoise)
+	    qs->quietStart = i + qs->padBlock;
+	qs->nNoise = 0;
+	qs->inNoise = 0;
     }
-    pcts[nPcts++] = pct;
-/*    printFloatArray("getThresh: pcts[]", pcts, nPcts);*/
 
-    /* Find median of pcts. First make a copy before calling percentile. */
-    static float *pctsCopy = NULL;
-    size_t pctsCopySize = 0;
-    BUFGROW(pctsCopy, ep->ns_nRecent, ERMA_NO_MEMORY_GETTHRESH);
-    memcpy(pctsCopy, pcts, nPcts * sizeof(pcts[0]));
-    float median = percentile(pctsCopy, nPcts, 0.5);	//0.5 = median
+    /* Pass on the blocks that are too far back for any noise to reach. */
+    if (!qs->inNoise)
+	streamEmit(qs, qs->quietStart, i - qs->nNoise + 1 - qs->padBlock, qt);
+}
+
+
+/* Get ready to find the quiet times in a new file with sample rate sRate. */
+void quietStreamStart(QUIETSTREAM *qs, float sRate, ERMAPARAMS *ep,
+		      char *baseDir)
+{
+    loadPcts(ep, baseDir);
+    qs->ep = ep;
+    qs->sRate = sRate;
+    qs->blockLen = round(ep->ns_tBlockS * sRate);
+    qs->blockDurS = qs->blockLen / sRate;
+    qs->minConsec = roundf(ep->ns_tConsecS / qs->blockDurS);
+    qs->padBlock = ep->ns_padSec / qs->blockDurS;
+    qs->nBlocks = 0;
+    qs->nNoise = 0;
+    qs->inNoise = 0;
+    qs->quietStart = 0;
+    qs->emitted = 0;
+    qs->nObs = 0;
+}
+
+
+/* Take in all the whole noise blocks in the first nSamp samples of raw, a
+ * buffer from wisprRawBuffer for the file described by wi, that haven't been
+ * taken in yet. Any newly found quiet times are added to qt.
+ */
+void quietStreamRaw(QUIETSTREAM *qs, void *raw, WISPRINFO *wi, size_t nSamp,
+		    QUIETTIMES *qt)
+{
+    int32 step = noiseStep(qs->ep);
 
-    /* Get the threshold. */
-    float thresh = median * ep->ns_medianMult;
+    for (int64 b = qs->nBlocks; (b + 1) * qs->blockLen <= nSamp; b++)
+	streamBlock(qs, rawBlockPower(raw, wi->sampleSize, b * qs->blockLen,
+				      qs->blockLen, step), qt);
+}
 
-    /* Save pcts in the pctPath file in case this is the last run. */
-    writeFloatArray(pcts, nPcts, pctPath);
 
-    return thresh;
+/* Finish off a file: add its last quiet time, if any, to qt, and keep its
+ * noise percentile for the threshold in later files.
+ */
+void quietStreamEnd(QUIETSTREAM *qs, QUIETTIMES *qt)
+{
+    if (!qs->inNoise)
+	streamEmit(qs, qs->quietStart, qs->nBlocks -
+		   (qs->nNoise > 0 ? qs->nNoise + qs->padBlock : 0) + 1, qt);
+    if (qs->nObs > 0)
+	notePct(p2Get(qs, qs->ep->ns_pctile), qs->ep);
 }
 
 
@@ -27,10 +27,41 @@ typedef struct {
 } QUIETTIMES;
 
 
+/* This holds the state for finding quiet times as a file is read; see the
+ * "Online version" part of quietTimes.c.
+ */
+typedef struct {
+    ERMAPARAMS *ep;
+    float sRate;
+    int32 blockLen;		//noise block length, samples
+    float blockDurS;		//...and s
+    int32 minConsec;		//blocks of noise needed for a noise section
+    int32 padBlock;		//blocks of padding around noise sections
+    int64 nBlocks;		//number of blocks taken in so far
+    int32 nNoise;		//number of consecutive blocks above threshold
+    int inNoise;		//currently in long-enough noise section?
+    int64 quietStart;		//start block of most recent non-noise section
+    int64 emitted;		//blocks before this are already in a quiet time
+    int32 nObs;			//P^2 percentile estimator: # of values so far,
+    float q[5];			//  marker heights,
+    double pos[5], want[5];	//  and their actual and desired positions
+} QUIETSTREAM;
+
+
 void initQUIETTIMES(QUIETTIMES *qt);
 void resetQuietTimes(QUIETTIMES *qt);
 QUIETTIMES *findQuietTimes(float *snd, size_t nSamp, float sRate,
 			   ERMAPARAMS *ep, QUIETTIMES *qt, char *baseDir);
+QUIETTIMES *findQuietTimesRaw(void *raw, WISPRINFO *wi, ERMAPARAMS *ep,
+			      QUIETTIMES *qt, char *baseDir);
+size_t decodeQuietTimes(void *raw, WISPRINFO *wi, QUIETTIMES *qt,
+			float **pSnd, size_t *pSndSize);
 void printQuietTimes(QUIETTIMES *qt);
+void quietTimesSavePcts(void);
+void quietStreamStart(QUIETSTREAM *qs, float sRate, ERMAPARAMS *ep,
+		      char *baseDir);
+void quietStreamRaw(QUIETSTREAM *qs, void *raw, WISPRINFO *wi, size_t nSamp,
+		    QUIETTIMES *qt);
+void quietStreamEnd(QUIETSTREAM *qs, QUIETTIMES *qt);
 
 #endif	/* _QUIETTIMES_H_ */
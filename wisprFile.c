@@ -152,11 +152,37 @@ WISPRINFO *wisprReadHeader(WISPRINFO *wi, char *filename)
  */
 void wisprReadSamples(WISPRINFO *wi, float **pSnd, size_t *pSndSize)
 {
-    /* store the read-in data temporarily until conversion to float */
+    void *raw = wisprReadRaw(wi);
+
+    BUFGROW(*pSnd, wi->nSamp, ERMA_NO_MEMORY_WISPR_PSND);
+    wisprDecode(*pSnd, raw, 0, wi->nSamp, wi);
+}
+
+
+/* Read all the samples into a buffer without converting them to float, and
+ * return a pointer to it. 2-byte samples end up as int16s in this machine's
+ * byte order; 3-byte samples are left packed the way they are in the file
+ * (little-endian). wisprDecode converts them to float. The buffer is re-used
+ * on the next call.
+ */
+void *wisprReadRaw(WISPRINFO *wi)
+{
+    void *raw = wisprRawBuffer(wi);
+
+    wisprReadRawPart(wi, raw, 0, wi->nSamp);
+    return raw;
+}
+
+
+/* Return a buffer big enough to hold all the samples of the file in wi in raw
+ * form (see wisprReadRaw). This is the same buffer wisprReadRaw uses.
+ */
+void *wisprRawBuffer(WISPRINFO *wi)
+{
     static void *sndBuf = NULL;
     static size_t sndBufSize = 0;
     
-    /* Ensure there's enough space in both sndBuf and *pSnd. */
+    /* Ensure there's enough space in sndBuf. */
     void *x = sndBuf;
     size_t xSize = sndBufSize;
     if (bufgrow(&sndBuf, &sndBufSize, wi->nSamp * wi->sampleSize, NULL)) {
@@ -165,17 +191,55 @@ void wisprReadSamples(WISPRINFO *wi, float **pSnd, size_t *pSndSize)
 		x, sndBuf, xSize, wi->nSamp * wi->sampleSize);
 	exit(ERMA_NO_MEMORY_WISPR_SNDBUF);
     }
-/*    fprintf(stderr, "wisprReadSamples: BUFGROW(x%x[len = %ld], %ld) ...",*/
-/*	    *pSnd, *pSndSize, wi->nSamp * sizeof((*pSnd)[0]));*/
-    BUFGROW(*pSnd, wi->nSamp, ERMA_NO_MEMORY_WISPR_PSND);
-/*    fprintf(stderr, " succeeded\n");*/
+    return sndBuf;
+}
+
+
+/* Read nSam samples in raw form (see wisprReadRaw), starting at sample
+ * offsetSam of the file, into the same place in raw, a buffer from
+ * wisprRawBuffer. This way a file can be read a piece at a time.
+ */
+void wisprReadRawPart(WISPRINFO *wi, void *raw, size_t offsetSam, size_t nSam)
+{
+    void *dst = (char *)raw + offsetSam * wi->sampleSize;
+
     if (wi->isWave) {
-	if (wavReadData(sndBuf, wi, 0, wi->nSamp))
+	if (wavReadData(dst, wi, offsetSam, nSam))
 	    exit(CANT_READ_WAVE);
-	int16ToFloat(*pSnd, sndBuf, wi->nSamp);
-    } else {
-	if (wisprReadFloat(*pSnd, sndBuf, 0, wi->nSamp, wi))
-	    exit(CANT_READ_WISPR_FLOATS);
+	return;
+    }
+
+    fseek(wi->fp, WISPR_HEADER_SIZE + offsetSam * wi->sampleSize, SEEK_SET);
+    switch(wi->sampleSize) {
+    case 2:
+	if (!readLittleEndian16(dst, nSam, wi->fp))
+	    exit(CANT_READ_WISPR_SAMPLES);
+	break;
+    case 3:
+	if (fread(dst, 3, nSam, wi->fp) != nSam)
+	    exit(CANT_READ_WISPR_SAMPLES);
+	break;
+    default:
+	exit(WISPR_BAD_SAMPLE_SIZE);
+    }
+}
+
+
+/* Convert nSam samples of raw, a buffer from wisprReadRaw, to float in sams[],
+ * starting at sample offsetSam of raw.
+ */
+void wisprDecode(float *sams, void *raw, size_t offsetSam, size_t nSam,
+		 WISPRINFO *wi)
+{
+    if (wi->sampleSize == 2) {
+	int16ToFloat(sams, (int16 *)raw + offsetSam, nSam);
+	return;
+    }
+    unsigned char *s = (unsigned char *)raw + offsetSam * 3;
+    for (size_t i = 0; i < nSam; i++, s += 3) {
+	int32 samVal = s[2] << 16 | s[1] << 8 | s[0];
+	samVal |= (s[2] & 0x80) ? 0xff000000 : 0;	//sign-extend
+	sams[i] = (float)samVal;
     }
 }
 
@@ -20,6 +20,11 @@ typedef struct wisprinfo {
 void wisprInitWISPRINFO(WISPRINFO *w);
 WISPRINFO *wisprReadHeader(WISPRINFO *w, char *filename);
 void wisprReadSamples(WISPRINFO *wi, float **pSnd, size_t *pSndSize);
+void *wisprReadRaw(WISPRINFO *wi);
+void *wisprRawBuffer(WISPRINFO *wi);
+void wisprReadRawPart(WISPRINFO *wi, void *raw, size_t offsetSam, size_t nSam);
+void wisprDecode(float *sams, void *raw, size_t offsetSam, size_t nSam,
+		 WISPRINFO *wi);
 size_t wisprReadFloat(float *sams, void *sndBuf, long offsetSam, size_t nSam,
 		      WISPRINFO *wi);
 void wisprPrintInfo(WISPRINFO *wi);